@@ -0,0 +1,30 @@
+#ifndef ESPNOW_MESSAGE_H
+#define ESPNOW_MESSAGE_H
+
+#include <stdint.h>
+
+// ESP-NOW wire format shared by the remote (src/ESPNOW.cpp) and the receiver (receiver/main.cpp).
+// Both sides must be flashed from the same revision of this header.
+
+enum SwitchMessageType : uint8_t {
+  MSG_SWITCH_SET = 0,     // Remote -> receiver: apply toggleSwitch to the outputs
+  MSG_STATE_REQUEST = 1,  // Remote -> receiver: reply with the current output state
+  MSG_STATE_PUSH = 2,     // Receiver -> remote: current output state (reply or unprompted change)
+};
+
+// Delta firmware update between peers (see lib/delta_ota). All of them start with the type byte.
+enum OtaMessageType : uint8_t {
+  MSG_OTA_OFFER = 0x20,    // Seeder -> broadcast: a patch is available (session, patch header)
+  MSG_OTA_REQUEST = 0x21,  // Peer -> seeder: send chunks starting at nextChunk (join or resume)
+  MSG_OTA_CHUNK = 0x22,    // Seeder -> peer: one chunk of the patch
+  MSG_OTA_ACK = 0x23,      // Peer -> seeder: every chunk before nextChunk was received
+  MSG_OTA_DONE = 0x24,     // Peer -> seeder: patch applied (status 0) or failed
+};
+
+// Structure to send data
+typedef struct struct_message {
+  uint8_t type;          // SwitchMessageType
+  bool toggleSwitch[4];  // Control 4 LEDs
+} struct_message;
+
+#endif
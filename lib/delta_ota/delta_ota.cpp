@@ -0,0 +1,639 @@
+#include "delta_ota.h"
+
+#include <Arduino.h>
+#include <esp_now.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <mbedtls/sha256.h>
+
+#include "espnow_message.h"
+
+const uint8_t OTA_CHUNK_SIZE = 200;
+const uint8_t OTA_WINDOW = 16;     // Unacknowledged chunks in flight per peer
+const uint8_t OTA_ACK_EVERY = 4;   // Receiver acknowledges every n chunks
+const uint8_t OTA_MAX_PEERS = 4;   // Peers a seeder serves at the same time
+const uint8_t OTA_QUEUE_LENGTH = OTA_WINDOW + 4;
+const unsigned long OTA_OFFER_INTERVAL = 1000;      // Duration (ms) between offers from a seeder
+const unsigned long OTA_RETRANSMIT_TIMEOUT = 300;   // Duration (ms) without ack progress before going back to the last ack
+const unsigned long OTA_RESUME_TIMEOUT = 1000;      // Duration (ms) without chunks before asking the seeder to resume
+const unsigned long OTA_ABORT_TIMEOUT = 60000;      // Duration (ms) without chunks before giving up
+const unsigned long OTA_REBOOT_DELAY = 1000;        // Duration (ms) between a successful update and the reboot
+const unsigned long OTA_OFFER_EXPIRY = 5000;        // Duration (ms) without offers before a pending one is forgotten
+
+const uint8_t BROADCAST_MAC[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+// REPLACE WITH YOUR OWN KEY (python tools/make_delta.py --new-key), the same one signs the patches.
+// Updates are refused while the key is all zeros.
+uint8_t deltaOtaKey[32] = {0};
+
+struct __attribute__((packed)) OtaOffer {
+  uint8_t type;
+  uint32_t session;
+  DeltaHeader header;
+};
+
+// MSG_OTA_REQUEST and MSG_OTA_ACK
+struct __attribute__((packed)) OtaPosition {
+  uint8_t type;
+  uint32_t session;
+  uint32_t nextChunk;
+};
+
+struct __attribute__((packed)) OtaChunk {
+  uint8_t type;
+  uint32_t session;
+  uint32_t index;
+  uint8_t length;
+  uint8_t data[OTA_CHUNK_SIZE];
+};
+
+// MSG_OTA_DONE status. Anything but OTA_STATUS_OK also tells the seeder to stop sending.
+enum OtaStatus : uint8_t {
+  OTA_STATUS_OK,             // Applied and verified
+  OTA_STATUS_VERIFY_FAILED,  // Result does not match the patch header
+  OTA_STATUS_WRITE_FAILED,   // A chunk could not be stored in the patch partition
+  OTA_STATUS_APPLY_FAILED,   // Malformed patch or the OTA slot could not be written
+  OTA_STATUS_TIMEOUT,        // No chunks for OTA_ABORT_TIMEOUT
+};
+
+struct __attribute__((packed)) OtaDone {
+  uint8_t type;
+  uint32_t session;
+  uint8_t status;  // OtaStatus
+};
+
+// Raw message copied out of the ESP-NOW receive callback
+struct OtaIncoming {
+  uint8_t mac[6];
+  uint8_t length;
+  uint8_t data[ESP_NOW_MAX_DATA_LEN];
+};
+
+// A peer served by this seeder
+struct OtaPeer {
+  bool used;
+  bool done;
+  uint8_t mac[6];
+  uint32_t base;        // First unacknowledged chunk
+  uint32_t next;        // Next chunk to send
+  uint32_t resendBase;  // Base of the last fast retransmit, so a burst of duplicate acks only rewinds once
+  unsigned long lastProgress;
+};
+
+enum ApplyStage : uint8_t { APPLY_HEADER, APPLY_OP, APPLY_ARGS, APPLY_INSERT, APPLY_ERROR };
+
+QueueHandle_t otaQueue = nullptr;
+DeltaOtaState otaState = DELTA_OTA_IDLE;
+unsigned long otaStateTime = 0;
+
+const esp_partition_t *patchPartition = nullptr;
+const esp_partition_t *runningPartition = nullptr;
+
+// SHA-256 of the first runningHashSize bytes of the running image (hashing takes a while, so keep it)
+uint8_t runningHash[32];
+uint32_t runningHashSize = 0;
+
+// Seeder
+DeltaHeader seedHeader;
+uint32_t seedSession = 0;
+uint32_t seedTotalChunks = 0;
+unsigned long lastOfferTime = 0;
+OtaPeer otaPeers[OTA_MAX_PEERS];
+
+// Offer waiting for the user's confirmation
+uint8_t offeredSeeder[6];
+OtaOffer pendingOffer;
+unsigned long lastOfferSeen = 0;
+
+// Receiver
+uint8_t rxSeeder[6];
+DeltaHeader rxHeader;
+uint32_t rxSession = 0;
+uint32_t rxNextChunk = 0;
+uint32_t rxTotalChunks = 0;
+unsigned long rxLastChunkTime = 0;
+unsigned long rxLastRequestTime = 0;
+const esp_partition_t *rxTarget = nullptr;
+esp_ota_handle_t rxOtaHandle = 0;
+mbedtls_sha256_context rxSha;
+
+// Streaming patch applier
+ApplyStage applyStage = APPLY_HEADER;
+uint8_t applyBuffer[sizeof(DeltaHeader)];
+uint32_t applyBufferLength = 0;
+uint8_t applyOp = 0;
+uint32_t applyRemaining = 0;
+uint32_t applyWritten = 0;
+
+uint32_t readLe32(const uint8_t *data) {
+  return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+uint32_t sessionOf(const DeltaHeader &header) {
+  return readLe32(header.newSha256);
+}
+
+uint32_t chunkCount(uint32_t patchSize) {
+  return (patchSize + OTA_CHUNK_SIZE - 1) / OTA_CHUNK_SIZE;
+}
+
+bool hashRunningImage(uint32_t size, uint8_t hash[32]) {
+  if (size > runningPartition->size) return false;
+
+  if (size != runningHashSize) {
+    mbedtls_sha256_context sha;
+    uint8_t block[256];
+
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts(&sha, 0);
+    for (uint32_t offset = 0; offset < size; offset += sizeof(block)) {
+      uint32_t length = min<uint32_t>(sizeof(block), size - offset);
+      if (esp_partition_read(runningPartition, offset, block, length) != ESP_OK) {
+        mbedtls_sha256_free(&sha);
+        return false;
+      }
+      mbedtls_sha256_update(&sha, block, length);
+    }
+    mbedtls_sha256_finish(&sha, runningHash);
+    mbedtls_sha256_free(&sha);
+    runningHashSize = size;
+  }
+
+  memcpy(hash, runningHash, 32);
+  return true;
+}
+
+// HMAC-SHA256 (RFC 2104) of the header fields before the signature
+void signHeader(const DeltaHeader &header, uint8_t signature[32]) {
+  uint8_t pad[64];
+  uint8_t inner[32];
+  mbedtls_sha256_context sha;
+
+  mbedtls_sha256_init(&sha);
+  for (int i = 0; i < 64; i++) pad[i] = (i < 32 ? deltaOtaKey[i] : 0) ^ 0x36;
+  mbedtls_sha256_starts(&sha, 0);
+  mbedtls_sha256_update(&sha, pad, sizeof(pad));
+  mbedtls_sha256_update(&sha, (const uint8_t *)&header, offsetof(DeltaHeader, signature));
+  mbedtls_sha256_finish(&sha, inner);
+
+  for (int i = 0; i < 64; i++) pad[i] ^= 0x36 ^ 0x5C;
+  mbedtls_sha256_starts(&sha, 0);
+  mbedtls_sha256_update(&sha, pad, sizeof(pad));
+  mbedtls_sha256_update(&sha, inner, sizeof(inner));
+  mbedtls_sha256_finish(&sha, signature);
+  mbedtls_sha256_free(&sha);
+}
+
+bool headerSigned(const DeltaHeader &header) {
+  uint8_t keyBits = 0;
+  for (int i = 0; i < 32; i++) keyBits |= deltaOtaKey[i];
+  if (keyBits == 0) return false;  // No key configured
+
+  uint8_t expected[32];
+  signHeader(header, expected);
+  uint8_t difference = 0;  // Compare in constant time
+  for (int i = 0; i < 32; i++) difference |= expected[i] ^ header.signature[i];
+  return difference == 0;
+}
+
+void ensurePeer(const uint8_t *mac) {
+  if (esp_now_is_peer_exist(mac)) return;
+
+  esp_now_peer_info_t peer = {};
+  memcpy(peer.peer_addr, mac, 6);
+  peer.channel = 0;
+  peer.encrypt = false;
+  esp_now_add_peer(&peer);
+}
+
+bool otaSend(const uint8_t *mac, const void *message, size_t length) {
+  ensurePeer(mac);
+  return esp_now_send(mac, (const uint8_t *)message, length) == ESP_OK;
+}
+
+void setOtaState(DeltaOtaState state) {
+  otaState = state;
+  otaStateTime = millis();
+}
+
+// We are a seeder when the patch partition holds a patch whose result is the image we run
+void deltaOtaInit() {
+  otaQueue = xQueueCreate(OTA_QUEUE_LENGTH, sizeof(OtaIncoming));
+  runningPartition = esp_ota_get_running_partition();
+  patchPartition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)0x41, "patch");
+  if (patchPartition == nullptr || runningPartition == nullptr) {
+    Serial.println("Delta OTA: partitions not found");
+    return;
+  }
+
+  uint8_t hash[32];
+  if (esp_partition_read(patchPartition, 0, &seedHeader, sizeof(seedHeader)) != ESP_OK) return;
+  if (seedHeader.magic != DELTA_MAGIC || seedHeader.patchSize > patchPartition->size || !headerSigned(seedHeader)) return;
+  if (!hashRunningImage(seedHeader.newSize, hash) || memcmp(hash, seedHeader.newSha256, 32) != 0) return;
+
+  seedSession = sessionOf(seedHeader);
+  seedTotalChunks = chunkCount(seedHeader.patchSize);
+  setOtaState(DELTA_OTA_SEEDING);
+  Serial.printf("Delta OTA: seeding %lu byte patch\n", (unsigned long)seedHeader.patchSize);
+}
+
+bool isDeltaOtaMessage(const uint8_t *data, int len) {
+  return len > 0 && data[0] >= MSG_OTA_OFFER && data[0] <= MSG_OTA_DONE;
+}
+
+// Runs in the Wi-Fi task: copy and defer all work to deltaOtaLoop()
+void deltaOtaReceive(const uint8_t *mac, const uint8_t *data, int len) {
+  if (otaQueue == nullptr || len <= 0 || len > ESP_NOW_MAX_DATA_LEN) return;
+
+  OtaIncoming incoming;
+  memcpy(incoming.mac, mac, 6);
+  incoming.length = len;
+  memcpy(incoming.data, data, len);
+  xQueueSend(otaQueue, &incoming, 0);  // Drop when full, the window protocol resends
+}
+
+/*============================== PATCH APPLIER ==============================*/
+bool writeOutput(const uint8_t *data, uint32_t length) {
+  if (applyWritten + length > rxHeader.newSize) return false;
+  if (esp_ota_write(rxOtaHandle, data, length) != ESP_OK) return false;
+  mbedtls_sha256_update(&rxSha, data, length);
+  applyWritten += length;
+  return true;
+}
+
+bool copyFromRunningImage(uint32_t offset, uint32_t length) {
+  if (offset > rxHeader.oldSize || length > rxHeader.oldSize - offset) return false;
+
+  uint8_t block[256];
+  while (length > 0) {
+    uint32_t blockLength = min<uint32_t>(sizeof(block), length);
+    if (esp_partition_read(runningPartition, offset, block, blockLength) != ESP_OK) return false;
+    if (!writeOutput(block, blockLength)) return false;
+    offset += blockLength;
+    length -= blockLength;
+  }
+  return true;
+}
+
+// Feed patch bytes in arrival order; operations may span chunk boundaries
+void applyPatchBytes(const uint8_t *data, uint32_t length) {
+  uint32_t i = 0;
+
+  while (i < length && applyStage != APPLY_ERROR) {
+    switch (applyStage) {
+      case APPLY_HEADER: {
+        uint32_t n = min<uint32_t>(length - i, sizeof(DeltaHeader) - applyBufferLength);
+        memcpy(applyBuffer + applyBufferLength, data + i, n);
+        applyBufferLength += n;
+        i += n;
+        if (applyBufferLength == sizeof(DeltaHeader)) {
+          // The patch must be the one that was offered
+          applyStage = memcmp(applyBuffer, &rxHeader, sizeof(DeltaHeader)) == 0 ? APPLY_OP : APPLY_ERROR;
+        }
+        break;
+      }
+
+      case APPLY_OP:
+        applyOp = data[i++];
+        applyBufferLength = 0;
+        applyStage = (applyOp == DELTA_OP_COPY || applyOp == DELTA_OP_INSERT) ? APPLY_ARGS : APPLY_ERROR;
+        break;
+
+      case APPLY_ARGS: {
+        uint32_t argsLength = applyOp == DELTA_OP_COPY ? 8 : 4;
+        uint32_t n = min<uint32_t>(length - i, argsLength - applyBufferLength);
+        memcpy(applyBuffer + applyBufferLength, data + i, n);
+        applyBufferLength += n;
+        i += n;
+        if (applyBufferLength < argsLength) break;
+
+        if (applyOp == DELTA_OP_COPY) {
+          applyStage = copyFromRunningImage(readLe32(applyBuffer), readLe32(applyBuffer + 4)) ? APPLY_OP : APPLY_ERROR;
+        } else {
+          applyRemaining = readLe32(applyBuffer);
+          applyStage = applyRemaining > 0 ? APPLY_INSERT : APPLY_OP;
+        }
+        break;
+      }
+
+      case APPLY_INSERT: {
+        uint32_t n = min<uint32_t>(length - i, applyRemaining);
+        if (!writeOutput(data + i, n)) {
+          applyStage = APPLY_ERROR;
+          break;
+        }
+        i += n;
+        applyRemaining -= n;
+        if (applyRemaining == 0) applyStage = APPLY_OP;
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+}
+
+/*================================ RECEIVER ================================*/
+void sendPosition(uint8_t type) {
+  OtaPosition position = {type, rxSession, rxNextChunk};
+  otaSend(rxSeeder, &position, sizeof(position));
+  rxLastRequestTime = millis();
+}
+
+// A signed patch for the image we run that fits the partitions
+bool offerApplies(const OtaOffer &offer) {
+  const DeltaHeader &header = offer.header;
+
+  uint8_t hash[32];
+  if (header.magic != DELTA_MAGIC || offer.session != sessionOf(header)) return false;
+  if (!headerSigned(header)) return false;
+  if (header.patchSize > patchPartition->size) return false;
+
+  const esp_partition_t *target = esp_ota_get_next_update_partition(nullptr);
+  if (target == nullptr || header.newSize > target->size) return false;
+  return hashRunningImage(header.oldSize, hash) && memcmp(hash, header.oldSha256, 32) == 0;  // Otherwise not our image
+}
+
+bool startReceiving(const uint8_t *mac, const OtaOffer &offer) {
+  const DeltaHeader &header = offer.header;
+
+  rxTarget = esp_ota_get_next_update_partition(nullptr);
+  if (esp_ota_begin(rxTarget, header.newSize, &rxOtaHandle) != ESP_OK) return false;
+
+  // Keep a copy of the patch so this peer can seed the others once it runs the new image
+  uint32_t eraseSize = (header.patchSize + 4095) & ~4095UL;
+  if (esp_partition_erase_range(patchPartition, 0, eraseSize) != ESP_OK) {
+    esp_ota_abort(rxOtaHandle);
+    return false;
+  }
+
+  memcpy(rxSeeder, mac, 6);
+  rxHeader = header;
+  rxSession = offer.session;
+  rxNextChunk = 0;
+  rxTotalChunks = chunkCount(header.patchSize);
+  rxLastChunkTime = millis();
+
+  mbedtls_sha256_init(&rxSha);
+  mbedtls_sha256_starts(&rxSha, 0);
+  applyStage = APPLY_HEADER;
+  applyBufferLength = 0;
+  applyWritten = 0;
+
+  setOtaState(DELTA_OTA_RECEIVING);
+  Serial.printf("Delta OTA: receiving %lu byte patch for a %lu byte image\n", (unsigned long)header.patchSize, (unsigned long)header.newSize);
+  sendPosition(MSG_OTA_REQUEST);
+  return true;
+}
+
+void finishReceiving() {
+  uint8_t hash[32];
+  mbedtls_sha256_finish(&rxSha, hash);
+  mbedtls_sha256_free(&rxSha);
+
+  bool ok = applyStage == APPLY_OP && applyWritten == rxHeader.newSize && memcmp(hash, rxHeader.newSha256, 32) == 0;
+  if (ok) ok = esp_ota_end(rxOtaHandle) == ESP_OK && esp_ota_set_boot_partition(rxTarget) == ESP_OK;
+  else esp_ota_abort(rxOtaHandle);
+
+  OtaDone done = {MSG_OTA_DONE, rxSession, ok ? OTA_STATUS_OK : OTA_STATUS_VERIFY_FAILED};
+  otaSend(rxSeeder, &done, sizeof(done));
+
+  setOtaState(ok ? DELTA_OTA_DONE : DELTA_OTA_FAILED);
+  Serial.println(ok ? "Delta OTA: image verified, rebooting" : "Delta OTA: verification failed");
+}
+
+// Give up on the session and tell the seeder, so it stops streaming to us
+void abortReceiving(OtaStatus status) {
+  mbedtls_sha256_free(&rxSha);
+  esp_ota_abort(rxOtaHandle);
+
+  OtaDone done = {MSG_OTA_DONE, rxSession, status};
+  otaSend(rxSeeder, &done, sizeof(done));
+
+  setOtaState(DELTA_OTA_FAILED);
+  Serial.printf("Delta OTA: transfer aborted (%u)\n", status);
+}
+
+void handleOffer(const uint8_t *mac, const OtaIncoming &incoming) {
+  if (incoming.length < sizeof(OtaOffer)) return;
+
+  OtaOffer offer;
+  memcpy(&offer, incoming.data, sizeof(offer));
+
+  if (otaState == DELTA_OTA_IDLE || otaState == DELTA_OTA_OFFERED) {
+    // Nothing is written before the user confirms: remember the offer for deltaOtaAccept()
+    if (!offerApplies(offer)) return;
+    if (otaState == DELTA_OTA_IDLE) Serial.println("Delta OTA: signed update offered, waiting for confirmation");
+    memcpy(offeredSeeder, mac, 6);
+    pendingOffer = offer;
+    lastOfferSeen = millis();
+    if (otaState == DELTA_OTA_IDLE) setOtaState(DELTA_OTA_OFFERED);
+  } else if (otaState == DELTA_OTA_RECEIVING && offer.session == rxSession && memcmp(mac, rxSeeder, 6) == 0) {
+    // The seeder may have dropped us after a radio gap: resume where we are
+    if (millis() - rxLastChunkTime > OTA_RESUME_TIMEOUT) sendPosition(MSG_OTA_REQUEST);
+  }
+}
+
+void handleChunk(const uint8_t *mac, const OtaIncoming &incoming) {
+  if (otaState != DELTA_OTA_RECEIVING || incoming.length < offsetof(OtaChunk, data)) return;
+
+  OtaChunk chunk;
+  memcpy(&chunk, incoming.data, min<uint32_t>(incoming.length, sizeof(chunk)));
+  if (chunk.session != rxSession || memcmp(mac, rxSeeder, 6) != 0) return;
+
+  rxLastChunkTime = millis();
+
+  // Out of order (a chunk was lost): tell the seeder where we are so it goes back
+  if (chunk.index != rxNextChunk) {
+    sendPosition(MSG_OTA_ACK);
+    return;
+  }
+
+  uint32_t offset = chunk.index * OTA_CHUNK_SIZE;
+  uint32_t expectedLength = min<uint32_t>(OTA_CHUNK_SIZE, rxHeader.patchSize - offset);
+  if (chunk.length != expectedLength || incoming.length < offsetof(OtaChunk, data) + expectedLength) return;
+
+  // A chunk is only acknowledged once it is stored, a failed flash write ends the session
+  if (esp_partition_write(patchPartition, offset, chunk.data, chunk.length) != ESP_OK) {
+    abortReceiving(OTA_STATUS_WRITE_FAILED);
+    return;
+  }
+  applyPatchBytes(chunk.data, chunk.length);
+  rxNextChunk++;
+
+  if (applyStage == APPLY_ERROR) {
+    abortReceiving(OTA_STATUS_APPLY_FAILED);
+    return;
+  }
+
+  if (rxNextChunk == rxTotalChunks) finishReceiving();
+  else if (rxNextChunk % OTA_ACK_EVERY == 0) sendPosition(MSG_OTA_ACK);
+}
+
+/*================================= SEEDER =================================*/
+OtaPeer *findPeer(const uint8_t *mac, bool create) {
+  OtaPeer *freeSlot = nullptr;
+
+  for (int i = 0; i < OTA_MAX_PEERS; i++) {
+    if (otaPeers[i].used && memcmp(otaPeers[i].mac, mac, 6) == 0) return &otaPeers[i];
+    if (!freeSlot && (!otaPeers[i].used || otaPeers[i].done)) freeSlot = &otaPeers[i];
+  }
+  if (!create || !freeSlot) return nullptr;
+
+  memset(freeSlot, 0, sizeof(OtaPeer));
+  freeSlot->used = true;
+  freeSlot->resendBase = UINT32_MAX;
+  memcpy(freeSlot->mac, mac, 6);
+  return freeSlot;
+}
+
+void handlePosition(const uint8_t *mac, const OtaIncoming &incoming) {
+  if (otaState != DELTA_OTA_SEEDING || incoming.length < sizeof(OtaPosition)) return;
+
+  OtaPosition position;
+  memcpy(&position, incoming.data, sizeof(position));
+  if (position.session != seedSession || position.nextChunk > seedTotalChunks) return;
+
+  OtaPeer *peer = findPeer(mac, position.type == MSG_OTA_REQUEST);
+  if (peer == nullptr) return;
+
+  if (position.type == MSG_OTA_REQUEST) {
+    // Join or resume
+    peer->done = false;
+    peer->base = peer->next = position.nextChunk;
+    peer->lastProgress = millis();
+  } else if (position.nextChunk > peer->base) {
+    peer->base = position.nextChunk;
+    if (peer->next < peer->base) peer->next = peer->base;
+    peer->lastProgress = millis();
+  } else if (position.nextChunk == peer->base && peer->next > peer->base && peer->resendBase != peer->base) {
+    // Duplicate ack: a chunk was lost, go back once without waiting for the timeout
+    peer->next = peer->base;
+    peer->resendBase = peer->base;
+  }
+}
+
+void handleDone(const uint8_t *mac, const OtaIncoming &incoming) {
+  if (otaState != DELTA_OTA_SEEDING || incoming.length < sizeof(OtaDone)) return;
+
+  OtaDone done;
+  memcpy(&done, incoming.data, sizeof(done));
+  OtaPeer *peer = findPeer(mac, false);
+  if (done.session != seedSession || peer == nullptr) return;
+
+  peer->done = true;
+  Serial.printf("Delta OTA: peer %02X:%02X:%02X %s\n", mac[3], mac[4], mac[5], done.status == OTA_STATUS_OK ? "updated" : "failed");
+}
+
+bool sendChunk(OtaPeer &peer, uint32_t index) {
+  OtaChunk chunk;
+  uint32_t offset = index * OTA_CHUNK_SIZE;
+
+  chunk.type = MSG_OTA_CHUNK;
+  chunk.session = seedSession;
+  chunk.index = index;
+  chunk.length = min<uint32_t>(OTA_CHUNK_SIZE, seedHeader.patchSize - offset);
+  if (esp_partition_read(patchPartition, offset, chunk.data, chunk.length) != ESP_OK) return false;
+
+  return otaSend(peer.mac, &chunk, offsetof(OtaChunk, data) + chunk.length);
+}
+
+void seederLoop() {
+  unsigned long now = millis();
+
+  if (now - lastOfferTime >= OTA_OFFER_INTERVAL) {
+    OtaOffer offer = {MSG_OTA_OFFER, seedSession, seedHeader};
+    otaSend(BROADCAST_MAC, &offer, sizeof(offer));
+    lastOfferTime = now;
+  }
+
+  for (int i = 0; i < OTA_MAX_PEERS; i++) {
+    OtaPeer &peer = otaPeers[i];
+    if (!peer.used || peer.done) continue;
+
+    // No ack progress: go back to the first unacknowledged chunk
+    if (peer.next > peer.base && now - peer.lastProgress > OTA_RETRANSMIT_TIMEOUT) {
+      peer.next = peer.base;
+      peer.lastProgress = now;
+    }
+
+    while (peer.next < seedTotalChunks && peer.next < peer.base + OTA_WINDOW) {
+      if (!sendChunk(peer, peer.next)) break;  // Radio queue full, continue on the next loop
+      peer.next++;
+    }
+  }
+}
+
+/*================================== LOOP ==================================*/
+void deltaOtaLoop() {
+  if (otaQueue == nullptr || patchPartition == nullptr) return;
+
+  OtaIncoming incoming;
+  while (xQueueReceive(otaQueue, &incoming, 0) == pdTRUE) {
+    switch (incoming.data[0]) {
+      case MSG_OTA_OFFER:
+        handleOffer(incoming.mac, incoming);
+        break;
+      case MSG_OTA_CHUNK:
+        handleChunk(incoming.mac, incoming);
+        break;
+      case MSG_OTA_REQUEST:
+      case MSG_OTA_ACK:
+        handlePosition(incoming.mac, incoming);
+        break;
+      case MSG_OTA_DONE:
+        handleDone(incoming.mac, incoming);
+        break;
+    }
+  }
+
+  unsigned long now = millis();
+  switch (otaState) {
+    case DELTA_OTA_OFFERED:
+      if (now - lastOfferSeen > OTA_OFFER_EXPIRY) setOtaState(DELTA_OTA_IDLE);  // The seeder went away
+      break;
+    case DELTA_OTA_SEEDING:
+      seederLoop();
+      break;
+    case DELTA_OTA_RECEIVING:
+      if (now - rxLastChunkTime > OTA_ABORT_TIMEOUT) abortReceiving(OTA_STATUS_TIMEOUT);
+      else if (now - rxLastChunkTime > OTA_RESUME_TIMEOUT && now - rxLastRequestTime > OTA_RESUME_TIMEOUT) sendPosition(MSG_OTA_REQUEST);
+      break;
+    case DELTA_OTA_DONE:
+      if (now - otaStateTime > OTA_REBOOT_DELAY) esp_restart();
+      break;
+    case DELTA_OTA_FAILED:
+      if (now - otaStateTime > 3000) setOtaState(DELTA_OTA_IDLE);  // Accept the next offer
+      break;
+    default:
+      break;
+  }
+}
+
+bool deltaOtaAccept() {
+  if (otaState != DELTA_OTA_OFFERED) return false;
+  if (!startReceiving(offeredSeeder, pendingOffer)) setOtaState(DELTA_OTA_FAILED);
+  return true;
+}
+
+DeltaOtaState deltaOtaState() {
+  return otaState;
+}
+
+uint8_t deltaOtaProgress() {
+  if (otaState == DELTA_OTA_RECEIVING) return rxTotalChunks ? rxNextChunk * 100 / rxTotalChunks : 0;
+  if (otaState == DELTA_OTA_DONE) return 100;
+  if (otaState != DELTA_OTA_SEEDING) return 0;
+
+  // Seeding: the slowest active peer
+  uint32_t slowest = seedTotalChunks;
+  for (int i = 0; i < OTA_MAX_PEERS; i++) {
+    if (otaPeers[i].used && !otaPeers[i].done) slowest = min(slowest, otaPeers[i].base);
+  }
+  return seedTotalChunks ? slowest * 100 / seedTotalChunks : 100;
+}
+
+bool deltaOtaBusy() {
+  return otaState == DELTA_OTA_RECEIVING || otaState == DELTA_OTA_DONE;
+}
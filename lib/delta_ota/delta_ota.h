@@ -0,0 +1,61 @@
+#ifndef DELTA_OTA_H
+#define DELTA_OTA_H
+
+#include <stdint.h>
+
+// Delta firmware update distributed peer-to-peer over ESP-NOW
+//
+// A patch (made on the host with tools/make_delta.py) describes the new image as a list of
+// COPY ranges from the running image and INSERT literals. A peer that runs the new image and
+// holds the patch in its "patch" partition is a seeder: it offers the patch to everybody and
+// streams it in chunks with a sliding window (go-back-N on missing acks). A peer running the
+// matching old image applies the patch while it streams straight into the inactive OTA slot,
+// keeps a copy of the patch so it can seed the next peers once updated, verifies the SHA-256
+// of the result and reboots into it. A transfer interrupted by a radio gap resumes at the
+// last acknowledged chunk.
+//
+// Only signed patches are accepted: the header carries an HMAC-SHA256 made with a key shared by
+// tools/make_delta.py and the devices (deltaOtaKey in delta_ota.cpp). It covers both image hashes,
+// so the offer and the resulting image are authenticated before the boot partition is switched.
+// A valid offer is only applied after the user confirms it on the device (deltaOtaAccept()).
+//
+// Patch layout (little endian):
+//   DeltaHeader, then operations:
+//     0x01 COPY   u32 oldOffset, u32 length
+//     0x02 INSERT u32 length, length bytes
+
+const uint32_t DELTA_MAGIC = 0x50445248;  // "HRDP"
+const uint8_t DELTA_OP_COPY = 0x01;
+const uint8_t DELTA_OP_INSERT = 0x02;
+
+struct DeltaHeader {
+  uint32_t magic;
+  uint32_t patchSize;  // Whole patch including this header
+  uint32_t oldSize;
+  uint32_t newSize;
+  uint8_t oldSha256[32];  // SHA-256 of the first oldSize bytes of the image the patch applies to
+  uint8_t newSha256[32];  // SHA-256 of the resulting image
+  uint8_t signature[32];  // HMAC-SHA256 of the fields above with the shared key
+};
+
+enum DeltaOtaState : uint8_t {
+  DELTA_OTA_IDLE,
+  DELTA_OTA_OFFERED,    // A signed patch for this image is offered, waiting for deltaOtaAccept()
+  DELTA_OTA_SEEDING,    // Offering the stored patch to other peers
+  DELTA_OTA_RECEIVING,  // Applying a patch from a seeder
+  DELTA_OTA_DONE,       // Patch applied, rebooting into the new image
+  DELTA_OTA_FAILED,
+};
+
+bool isDeltaOtaMessage(const uint8_t *data, int len);
+void deltaOtaInit();  // Put this in the void setup in the main.cpp, before ESP-NOW starts
+void deltaOtaReceive(const uint8_t *mac, const uint8_t *data, int len);  // Safe to call from the ESP-NOW receive callback
+void deltaOtaLoop();  // Call regularly while ESP-NOW is initialized, and while deltaOtaBusy()
+
+bool deltaOtaAccept();  // User confirmed the offered update. False when nothing is offered.
+
+DeltaOtaState deltaOtaState();
+uint8_t deltaOtaProgress();  // 0-100 for the current transfer
+bool deltaOtaBusy();         // True while a patch is being received (don't sleep)
+
+#endif
@@ -0,0 +1,71 @@
+#include <Arduino.h>
+
+#include <WiFi.h>
+#include <esp_now.h>
+
+#include "delta_ota.h"
+#include "espnow_message.h"
+#include "switch_receiver.h"
+
+// Receiver firmware for the Home Automation menu of the remote.
+// The ESP-NOW receive callback runs in the Wi-Fi task, so it only validates the packet (see
+// switch_receiver.cpp) and wakes the relay task with a direct task notification.
+
+#define STATUS_INDICATOR 2
+#define CONFIRM_BUTTON 0  // BOOT button: press while the LED blinks to install an offered firmware update
+
+TaskHandle_t relayTaskHandle = nullptr;
+
+// Callback function when data is received (Wi-Fi task: keep it short)
+void OnDataRecv(const uint8_t *mac, const uint8_t *incomingData, int len) {
+  if (isDeltaOtaMessage(incomingData, len)) {
+    deltaOtaReceive(mac, incomingData, len);
+    return;
+  }
+
+  uint32_t notify = receiverHandlePacket(mac, incomingData, len);
+  if (notify != 0) xTaskNotify(relayTaskHandle, notify, eSetBits);
+}
+
+// Applies output changes, keeps the remotes up to date and persists the outputs
+void relayTask(void *parameter) {
+  for (;;) {
+    uint32_t notify = 0;
+    TickType_t wait = receiverSavePending() ? pdMS_TO_TICKS(RECEIVER_SAVE_DELAY) : portMAX_DELAY;
+    xTaskNotifyWait(0, UINT32_MAX, &notify, wait);
+    receiverProcess(notify);
+  }
+}
+
+void setup() {
+  Serial.begin(115200);  // Initialize serial communication
+  pinMode(STATUS_INDICATOR, OUTPUT);
+  pinMode(CONFIRM_BUTTON, INPUT_PULLUP);
+
+  receiverBegin();  // Outputs restored before the radio can change them
+  xTaskCreatePinnedToCore(relayTask, "relay", 4096, nullptr, configMAX_PRIORITIES - 2, &relayTaskHandle, 1);
+
+  // Set device as a Wi-Fi Station
+  WiFi.mode(WIFI_STA);
+  digitalWrite(STATUS_INDICATOR, HIGH);
+  Serial.print("Receiver MAC Address: ");
+  Serial.println(WiFi.macAddress());
+
+  // Init ESP-NOW
+  if (esp_now_init() != ESP_OK) {
+    Serial.println("Error initializing ESP-NOW");
+    return;
+  }
+  esp_now_register_recv_cb(OnDataRecv);  // Register data received callback
+}
+
+void loop() {
+  // Switching happens in the ESP-NOW callback and the relay task; the loop only serves firmware updates
+  deltaOtaLoop();
+
+  // A signed update is only installed after someone confirms it at the receiver
+  bool offered = deltaOtaState() == DELTA_OTA_OFFERED;
+  digitalWrite(STATUS_INDICATOR, offered ? (millis() / 250) % 2 : HIGH);
+  if (offered && digitalRead(CONFIRM_BUTTON) == LOW) deltaOtaAccept();
+  delay(2);
+}
@@ -0,0 +1,165 @@
+#include "switch_receiver.h"
+
+#include <Arduino.h>
+
+#include <Preferences.h>
+#include <esp_now.h>
+#include <esp_timer.h>
+
+#include <atomic>
+
+#include "espnow_message.h"
+
+// The receive callback only validates the packet and hands the new output state to the relay task
+// without locks: the state goes into an atomic word, new remotes into a queue.
+
+// REPLACE WITH YOUR RELAY PINS
+const uint8_t RELAY_PINS[4] = {16, 17, 18, 19};
+
+const int MAX_REMOTES = 6;
+
+QueueHandle_t registrationQueue = nullptr;  // Sender MAC addresses, drained by the relay task
+
+std::atomic<uint8_t> targetOutputs(0);      // Bit i = relay i, written by the receive callback
+std::atomic<uint32_t> receiveTimestamp(0);  // esp_timer time (us) of the latest switch packet
+
+uint8_t currentOutputs = 0;  // Only touched by the relay task after receiverBegin()
+uint8_t remotes[MAX_REMOTES][6];
+int remoteCount = 0;
+
+bool saveRequired = false;
+unsigned long lastOutputChange = 0;
+
+Preferences preferences;
+
+// Receive-to-relay latency statistics (us)
+uint32_t latencyMin = UINT32_MAX;
+uint32_t latencyMax = 0;
+uint32_t latencySum = 0;
+uint32_t latencyCount = 0;
+
+uint8_t packOutputs(const bool toggleSwitch[4]) {
+  uint8_t bits = 0;
+  for (int i = 0; i < 4; i++) bits |= (toggleSwitch[i] ? 1 : 0) << i;
+  return bits;
+}
+
+void writeRelays(uint8_t bits) {
+  for (int i = 0; i < 4; i++) digitalWrite(RELAY_PINS[i], (bits >> i) & 1 ? HIGH : LOW);
+}
+
+void receiverBegin() {
+  // Restore the outputs before anything else so a power loss does not flip the relays
+  preferences.begin("receiver", false);
+  currentOutputs = preferences.getUChar("outputs", 0);
+  targetOutputs.store(currentOutputs);
+  for (int i = 0; i < 4; i++) pinMode(RELAY_PINS[i], OUTPUT);
+  writeRelays(currentOutputs);
+
+  if (registrationQueue == nullptr) registrationQueue = xQueueCreate(MAX_REMOTES, 6);
+}
+
+// Wi-Fi task: keep it short
+uint32_t receiverHandlePacket(const uint8_t *mac, const uint8_t *data, int len) {
+  if (len != sizeof(struct_message)) return 0;
+
+  struct_message message;
+  memcpy(&message, data, sizeof(message));
+
+  uint32_t notify = 0;
+  if (message.type == MSG_SWITCH_SET) {
+    receiveTimestamp.store((uint32_t)esp_timer_get_time(), std::memory_order_relaxed);
+    targetOutputs.store(packOutputs(message.toggleSwitch), std::memory_order_release);
+    notify |= RECEIVER_NOTIFY_APPLY;
+  } else if (message.type == MSG_STATE_REQUEST) {
+    notify |= RECEIVER_NOTIFY_PUSH;
+  } else {
+    return 0;
+  }
+
+  // Every sender is a remote that wants state pushes
+  if (xQueueSend(registrationQueue, mac, 0) == pdTRUE) notify |= RECEIVER_NOTIFY_REGISTER;
+  return notify;
+}
+
+void registerRemote(const uint8_t *mac) {
+  for (int i = 0; i < remoteCount; i++) {
+    if (memcmp(remotes[i], mac, 6) == 0) return;
+  }
+  if (remoteCount >= MAX_REMOTES) return;
+
+  esp_now_peer_info_t peerInfo = {};
+  memcpy(peerInfo.peer_addr, mac, 6);
+  peerInfo.channel = 0;
+  peerInfo.encrypt = false;
+  if (!esp_now_is_peer_exist(mac) && esp_now_add_peer(&peerInfo) != ESP_OK) {
+    Serial.println("Failed to add remote");
+    return;
+  }
+  memcpy(remotes[remoteCount++], mac, 6);
+  Serial.printf("Remote registered (%d)\n", remoteCount);
+}
+
+// Send the current output state to every registered remote
+void pushState() {
+  struct_message message;
+  message.type = MSG_STATE_PUSH;
+  for (int i = 0; i < 4; i++) message.toggleSwitch[i] = (currentOutputs >> i) & 1;
+
+  for (int i = 0; i < remoteCount; i++) {
+    esp_now_send(remotes[i], (const uint8_t *)&message, sizeof(message));
+  }
+}
+
+void recordLatency(uint32_t latency) {
+  latencyMin = min(latencyMin, latency);
+  latencyMax = max(latencyMax, latency);
+  latencySum += latency;
+  latencyCount++;
+  Serial.printf("Receive-to-relay: %lu us (min %lu, avg %lu, max %lu)\n", (unsigned long)latency, (unsigned long)latencyMin,
+                (unsigned long)(latencySum / latencyCount), (unsigned long)latencyMax);
+}
+
+// Applies output changes, keeps the remotes up to date and persists the outputs
+void receiverProcess(uint32_t notify) {
+  bool changed = false;
+  if (notify & RECEIVER_NOTIFY_APPLY) {
+    uint8_t outputs = targetOutputs.load(std::memory_order_acquire);
+    if (outputs != currentOutputs) {
+      writeRelays(outputs);  // Relays first, bookkeeping after
+      recordLatency((uint32_t)esp_timer_get_time() - receiveTimestamp.load(std::memory_order_relaxed));
+      currentOutputs = outputs;
+      changed = true;
+    }
+  }
+
+  if (notify & RECEIVER_NOTIFY_REGISTER) {
+    uint8_t mac[6];
+    while (xQueueReceive(registrationQueue, mac, 0) == pdTRUE) registerRemote(mac);
+  }
+
+  if (changed || (notify & RECEIVER_NOTIFY_PUSH)) pushState();
+
+  if (changed) {
+    saveRequired = true;
+    lastOutputChange = millis();
+  }
+
+  // Coalesce bursts of changes into one NVS write
+  if (saveRequired && millis() - lastOutputChange >= RECEIVER_SAVE_DELAY) {
+    preferences.putUChar("outputs", currentOutputs);
+    saveRequired = false;
+  }
+}
+
+bool receiverSavePending() {
+  return saveRequired;
+}
+
+uint8_t receiverOutputs() {
+  return currentOutputs;
+}
+
+ReceiverLatency receiverLatency() {
+  return {latencyMin, latencyMax, latencyCount > 0 ? latencySum / latencyCount : 0, latencyCount};
+}
@@ -0,0 +1,32 @@
+#ifndef SWITCH_RECEIVER_H
+#define SWITCH_RECEIVER_H
+
+#include <stdint.h>
+
+// Switch logic of the receiver, without the task and radio setup of main.cpp so it also builds
+// for the host loopback tests (test/test_espnow_loopback).
+// receiverHandlePacket() runs in the ESP-NOW receive callback, receiverProcess() in the relay task.
+
+// Work for the relay task, returned by receiverHandlePacket()
+const uint32_t RECEIVER_NOTIFY_APPLY = 1 << 0;     // New output state in targetOutputs
+const uint32_t RECEIVER_NOTIFY_PUSH = 1 << 1;      // A remote asked for the current state
+const uint32_t RECEIVER_NOTIFY_REGISTER = 1 << 2;  // New remote in the registration queue
+
+const unsigned long RECEIVER_SAVE_DELAY = 2000;  // Duration (ms) without changes before the outputs are written to NVS
+
+void receiverBegin();  // Restore the outputs from NVS and drive the relays, before the radio starts
+uint32_t receiverHandlePacket(const uint8_t *mac, const uint8_t *data, int len);  // 0 when there is nothing to do
+void receiverProcess(uint32_t notify);  // Also call it after RECEIVER_SAVE_DELAY without notification
+bool receiverSavePending();
+uint8_t receiverOutputs();  // Bit i = relay i
+
+// Receive-to-relay latency (us)
+struct ReceiverLatency {
+  uint32_t min;
+  uint32_t max;
+  uint32_t average;
+  uint32_t count;
+};
+ReceiverLatency receiverLatency();
+
+#endif
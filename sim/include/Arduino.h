@@ -0,0 +1,113 @@
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+// Arduino core for the simulator (see sim/sim_main.cpp): virtual clock, GPIO levels set by the
+// replayed events and Serial lines written to the trace.
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+
+using std::max;
+using std::min;
+
+#define PROGMEM
+#define RTC_DATA_ATTR
+#define IRAM_ATTR
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define constrain(value, low, high) ((value) < (low) ? (low) : ((value) > (high) ? (high) : (value)))
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_TIMEOUT 0x107
+
+typedef int gpio_num_t;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);  // Advances the virtual clock
+void delayMicroseconds(unsigned int us);
+void yield();
+int digitalRead(int pin);
+void digitalWrite(int pin, int level);
+void pinMode(int pin, int mode);
+
+// strlcpy is missing from some host C libraries
+size_t simStrlcpy(char *destination, const char *source, size_t size);
+#define strlcpy simStrlcpy
+
+class String {
+ public:
+  String(const char *text = "") : text(text != nullptr ? text : "") {}
+  String(int value) : text(std::to_string(value)) {}
+  String(const std::string &text) : text(text) {}
+  const char *c_str() const { return text.c_str(); }
+  size_t length() const { return text.size(); }
+  String operator+(const String &other) const { return String(text + other.text); }
+
+ private:
+  std::string text;
+};
+
+inline String operator+(const char *left, const String &right) { return String(left) + right; }
+
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t print(const char *text) { return write((const uint8_t *)text, strlen(text)); }
+  size_t print(const String &text) { return print(text.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int value) { return printf("%d", value); }
+  size_t print(unsigned int value) { return printf("%u", value); }
+  size_t print(long value) { return printf("%ld", value); }
+  size_t print(unsigned long value) { return printf("%lu", value); }
+  size_t print(double value, int digits = 2) { return printf("%.*f", digits, value); }
+  size_t println() { return print("\n"); }
+  template <typename T>
+  size_t println(T value) { return print(value) + println(); }
+  size_t println(double value, int digits) { return print(value, digits) + println(); }
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+// Output goes to the trace line by line, input comes from "serial" events of the script
+class HardwareSerial : public Print {
+ public:
+  void begin(unsigned long) {}
+  size_t setRxBufferSize(size_t size) { return size; }
+  int available();
+  int read();
+  int availableForWrite() { return 128; }
+  void flush() {}
+  operator bool() const { return true; }
+  size_t write(uint8_t c) override;
+  using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+typedef enum { ESP_SLEEP_WAKEUP_UNDEFINED, ESP_SLEEP_WAKEUP_EXT0, ESP_SLEEP_WAKEUP_TIMER } esp_sleep_wakeup_cause_t;
+esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t pin, int level);
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t us);
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause();
+void esp_deep_sleep_start();  // Ends the simulation (RAM is lost on the real device)
+void esp_restart();
+int64_t esp_timer_get_time();
+
+#endif
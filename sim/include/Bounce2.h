@@ -0,0 +1,49 @@
+#ifndef SIM_BOUNCE2_H
+#define SIM_BOUNCE2_H
+
+#include <Arduino.h>
+
+namespace Bounce2 {
+
+// Same debounce as Bounce2's default: a new level is accepted once it was stable for the interval
+class Button {
+ public:
+  void attach(int pin, int mode) {
+    this->pin = pin;
+    pinMode(pin, mode);
+    state = unstable = digitalRead(pin);
+    previousMillis = millis();
+  }
+  void interval(uint16_t ms) { intervalMillis = ms; }
+  void setPressedState(bool level) { pressedLevel = level; }
+
+  bool update() {
+    changed = false;
+    bool level = digitalRead(pin);
+    if (level != unstable) {
+      unstable = level;
+      previousMillis = millis();
+    } else if (level != state && millis() - previousMillis >= intervalMillis) {
+      state = level;
+      changed = true;
+    }
+    return changed;
+  }
+
+  bool pressed() const { return changed && state == pressedLevel; }
+  bool released() const { return changed && state != pressedLevel; }
+  bool isPressed() const { return state == pressedLevel; }
+
+ private:
+  int pin = 0;
+  bool state = HIGH;
+  bool unstable = HIGH;
+  bool changed = false;
+  bool pressedLevel = LOW;
+  uint16_t intervalMillis = 10;
+  unsigned long previousMillis = 0;
+};
+
+}  // namespace Bounce2
+
+#endif
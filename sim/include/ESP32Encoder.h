@@ -0,0 +1,16 @@
+#ifndef SIM_ESP32ENCODER_H
+#define SIM_ESP32ENCODER_H
+
+#include <stdint.h>
+
+extern int64_t simEncoderCount;  // Changed by "turn" events
+
+class ESP32Encoder {
+ public:
+  void attachHalfQuad(int, int) {}
+  void setCount(int64_t count) { simEncoderCount = count; }
+  int64_t getCount() { return simEncoderCount; }
+  void clearCount() { simEncoderCount = 0; }
+};
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef SIM_IRREMOTEESP8266_H
+#define SIM_IRREMOTEESP8266_H
+
+// The simulator only needs the A/C state builders of IRremoteESP8266 (ir_Sharp.h, ir_Daikin.h):
+// frames are generated by src/ir_emitter.cpp and transmitted by the simulated RMT.
+
+#include <stdint.h>
+
+const uint16_t kSharpAcStateLength = 13;
+const uint16_t kDaikin64Bits = 64;
+
+#endif
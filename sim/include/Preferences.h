@@ -0,0 +1,41 @@
+#ifndef SIM_PREFERENCES_H
+#define SIM_PREFERENCES_H
+
+// NVS key/value store in RAM, shared by every Preferences object so values survive a simulated reboot
+
+#include <Arduino.h>
+
+#include <map>
+#include <string>
+
+class Preferences {
+ public:
+  bool begin(const char *name, bool = false) {
+    space = name;
+    return true;
+  }
+  void end() {}
+  uint8_t getUChar(const char *key, uint8_t defaultValue = 0) {
+    auto entry = store().find(space + "/" + key);
+    return entry == store().end() ? defaultValue : entry->second;
+  }
+  size_t putUChar(const char *key, uint8_t value) {
+    store()[space + "/" + key] = value;
+    return 1;
+  }
+  bool clear() {
+    for (auto entry = store().begin(); entry != store().end();) {
+      entry = entry->first.compare(0, space.size() + 1, space + "/") == 0 ? store().erase(entry) : std::next(entry);
+    }
+    return true;
+  }
+
+ private:
+  std::string space;
+  static std::map<std::string, uint8_t> &store() {
+    static std::map<std::string, uint8_t> values;
+    return values;
+  }
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef SIM_U8G2LIB_H
+#define SIM_U8G2LIB_H
+
+// SH1106 128x64 display for the simulator. Lines, boxes, frames and bitmaps are drawn into the
+// page buffer like U8g2 does. There are no fonts here: text is drawn with placeholder glyphs of the
+// font size and also kept as a list of strings with their position. sendBuffer() hands both to the
+// trace (see sim_display.cpp).
+
+#include <Arduino.h>
+
+#define U8X8_PROGMEM
+#define U8X8_PIN_NONE 255
+#define U8G2_R0 0
+
+typedef int u8g2_uint_t;
+
+// Fonts: glyph width and height in pixels, enough for getStrWidth() and the font metrics
+extern const uint8_t u8g2_font_spleen8x16_mr[];
+extern const uint8_t u8g2_font_spleen6x12_mr[];
+extern const uint8_t u8g2_font_minuteconsole_mr[];
+extern const uint8_t u8g2_font_4x6_tr[];
+extern const uint8_t u8g2_font_6x13_tr[];
+extern const uint8_t u8g2_font_profont29_tr[];
+extern const uint8_t u8g2_font_profont11_tr[];
+
+struct u8g2_font_info_t {
+  uint8_t max_char_height;
+  int8_t y_offset;
+};
+
+struct u8g2_t {
+  const uint8_t *font;
+  u8g2_font_info_t font_info;
+};
+
+class U8G2 : public Print {
+ public:
+  bool begin();
+  void clearBuffer();
+  void clearDisplay() { clearBuffer(); }
+  void sendBuffer();
+  void setPowerSave(uint8_t enable);
+  uint8_t *getBufferPtr() { return buffer; }
+  uint8_t getBufferTileWidth() { return 16; }
+  uint8_t getBufferTileHeight() { return 8; }
+  u8g2_t *getU8g2() { return &state; }
+
+  void setFont(const uint8_t *font);
+  void setFontMode(uint8_t) {}
+  void setBitmapMode(uint8_t) {}
+  void setDrawColor(uint8_t color) { drawColor = color; }
+  uint8_t getDrawColor() { return drawColor; }
+  int8_t getAscent() { return state.font_info.max_char_height + state.font_info.y_offset; }
+  int8_t getDescent() { return state.font_info.y_offset; }
+  uint16_t getStrWidth(const char *text);
+
+  uint16_t drawStr(int x, int y, const char *text);
+  uint16_t drawUTF8(int x, int y, const char *text) { return drawStr(x, y, text); }
+  void drawPixel(int x, int y);
+  void drawHLine(int x, int y, int width);
+  void drawVLine(int x, int y, int height);
+  void drawBox(int x, int y, int width, int height);
+  void drawFrame(int x, int y, int width, int height);
+  void drawRFrame(int x, int y, int width, int height, int) { drawFrame(x, y, width, height); }
+  void drawXBMP(int x, int y, int width, int height, const uint8_t *bitmap);
+  size_t write(uint8_t c) override;
+  void setCursor(int x, int y) {
+    cursorX = x;
+    cursorY = y;
+  }
+
+ private:
+  uint8_t buffer[128 * 8];
+  u8g2_t state = {u8g2_font_6x13_tr, {13, -2}};
+  uint8_t drawColor = 1;
+  int cursorX = 0;
+  int cursorY = 0;
+};
+
+class U8G2_SH1106_128X64_NONAME_F_HW_I2C : public U8G2 {
+ public:
+  U8G2_SH1106_128X64_NONAME_F_HW_I2C(int, int) {}
+};
+
+#endif
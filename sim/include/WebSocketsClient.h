@@ -0,0 +1,31 @@
+#ifndef SIM_WEBSOCKETSCLIENT_H
+#define SIM_WEBSOCKETSCLIENT_H
+
+// Talks to the stand-in server in sim_websocket.cpp. Without Wi-Fi or with the server down
+// (simWsServerUp in sim.h, the default) the client never connects.
+
+#include <Arduino.h>
+
+typedef enum { WStype_ERROR, WStype_DISCONNECTED, WStype_CONNECTED, WStype_TEXT, WStype_BIN, WStype_PING, WStype_PONG } WStype_t;
+
+class WebSocketsClient {
+ public:
+  typedef void (*WebSocketClientEvent)(WStype_t type, uint8_t *payload, size_t length);
+
+  void begin(const char *host, uint16_t port, const char *url = "/", const char *protocol = "");
+  void onEvent(WebSocketClientEvent callback) { event = callback; }
+  void setReconnectInterval(unsigned long) {}
+  void enableHeartbeat(uint32_t, uint32_t, uint8_t) {}
+  void loop();
+  bool sendBIN(const uint8_t *payload, size_t length);
+  bool isConnected() { return connected; }
+  void disconnect();
+
+ private:
+  WebSocketClientEvent event = nullptr;
+  bool started = false;
+  bool connected = false;
+  uint64_t handshakeDoneUs = 0;  // 0 while no handshake is in progress
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef SIM_WIFI_H
+#define SIM_WIFI_H
+
+// By default there is no access point in the simulator: the station never connects (status stays
+// WL_DISCONNECTED), so the Wi-Fi features run into their timeouts like they would out of range.
+// Tests can put one in range with simWifiAccessPoint (sim.h).
+
+#include <Arduino.h>
+
+typedef enum { WIFI_OFF, WIFI_STA, WIFI_AP, WIFI_AP_STA } wifi_mode_t;
+typedef enum { WL_IDLE_STATUS, WL_NO_SSID_AVAIL, WL_SCAN_COMPLETED, WL_CONNECTED, WL_CONNECT_FAILED, WL_CONNECTION_LOST, WL_DISCONNECTED } wl_status_t;
+
+#define WIFI_SCAN_RUNNING (-1)
+
+class IPAddress {
+ public:
+  IPAddress(uint32_t address = 0) : address(address) {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : address(a | b << 8 | c << 16 | (uint32_t)d << 24) {}
+  operator uint32_t() const { return address; }
+
+ private:
+  uint32_t address;
+};
+
+class WiFiClass {
+ public:
+  wifi_mode_t getMode() { return wifiMode; }
+  bool mode(wifi_mode_t mode) {
+    wifiMode = mode;
+    return true;
+  }
+  wl_status_t begin(const char *, const char * = nullptr, int32_t = 0, const uint8_t * = nullptr, bool = true);
+  bool config(IPAddress, IPAddress, IPAddress, IPAddress = IPAddress(), IPAddress = IPAddress()) { return true; }
+  wl_status_t status();
+  bool disconnect(bool = false, bool = false);
+  uint8_t *BSSID() { return bssid; }
+  int32_t channel() { return 1; }
+  IPAddress localIP() { return IPAddress(); }
+  IPAddress gatewayIP() { return IPAddress(); }
+  IPAddress subnetMask() { return IPAddress(); }
+  IPAddress dnsIP(uint8_t = 0) { return IPAddress(); }
+  bool persistent(bool) { return true; }
+  bool setSleep(bool) { return true; }
+  int16_t scanNetworks(bool = false) { return 0; }
+  int16_t scanComplete() { return 0; }
+  void scanDelete() {}
+
+ private:
+  wifi_mode_t wifiMode = WIFI_OFF;
+  bool joining = false;
+  uint64_t joinStartUs = 0;
+  uint8_t bssid[6] = {};
+};
+
+extern WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef SIM_DRIVER_RMT_H
+#define SIM_DRIVER_RMT_H
+
+// Transmit-only RMT: a channel stays busy for the total duration of the items written to it,
+// measured on the virtual clock, and every write is recorded in simRmtFrames (see sim_ir.cpp)
+
+#include <Arduino.h>
+
+typedef enum { RMT_CHANNEL_0, RMT_CHANNEL_1, RMT_CHANNEL_2, RMT_CHANNEL_3, RMT_CHANNEL_4, RMT_CHANNEL_MAX = 8 } rmt_channel_t;
+typedef enum { RMT_CARRIER_LEVEL_LOW, RMT_CARRIER_LEVEL_HIGH } rmt_carrier_level_t;
+typedef enum { RMT_IDLE_LEVEL_LOW, RMT_IDLE_LEVEL_HIGH } rmt_idle_level_t;
+
+typedef struct {
+  uint32_t duration0 : 15;
+  uint32_t level0 : 1;
+  uint32_t duration1 : 15;
+  uint32_t level1 : 1;
+} rmt_item32_t;
+
+typedef struct {
+  uint32_t carrier_freq_hz;
+  rmt_carrier_level_t carrier_level;
+  rmt_idle_level_t idle_level;
+  uint8_t carrier_duty_percent;
+  bool carrier_en;
+  bool loop_en;
+  bool idle_output_en;
+} rmt_tx_config_t;
+
+typedef struct {
+  int rmt_mode;
+  rmt_channel_t channel;
+  gpio_num_t gpio_num;
+  uint8_t clk_div;
+  uint8_t mem_block_num;
+  uint32_t flags;
+  rmt_tx_config_t tx_config;
+} rmt_config_t;
+
+#define RMT_DEFAULT_CONFIG_TX(gpio, channel_id) \
+  {0, channel_id, gpio, 80, 1, 0, {38000, RMT_CARRIER_LEVEL_HIGH, RMT_IDLE_LEVEL_LOW, 33, true, false, true}}
+
+esp_err_t rmt_config(const rmt_config_t *config);
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rxBufferSize, int interruptFlags);
+esp_err_t rmt_driver_uninstall(rmt_channel_t channel);
+esp_err_t rmt_set_tx_carrier(rmt_channel_t channel, bool enable, uint16_t highLevel, uint16_t lowLevel, rmt_carrier_level_t level);
+esp_err_t rmt_write_items(rmt_channel_t channel, const rmt_item32_t *items, int itemCount, bool waitDone);
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, TickType_t wait);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef SIM_ESP_HEAP_CAPS_H
+#define SIM_ESP_HEAP_CAPS_H
+
+// The host heap has no meaningful size: reported as zero
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+
+inline size_t heap_caps_get_free_size(uint32_t) { return 0; }
+inline size_t heap_caps_get_minimum_free_size(uint32_t) { return 0; }
+inline size_t heap_caps_get_largest_free_block(uint32_t) { return 0; }
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef SIM_ESP_NOW_H
+#define SIM_ESP_NOW_H
+
+// Sent packets are written to the trace (see sim_radio.cpp) and always delivered; received
+// packets come from "espnow" events of the script or from the loopback peer (simEspNowPeer in sim.h).
+
+#include <Arduino.h>
+
+#define ESP_NOW_MAX_DATA_LEN 250
+#define ESP_NOW_ETH_ALEN 6
+
+typedef enum { ESP_NOW_SEND_SUCCESS, ESP_NOW_SEND_FAIL } esp_now_send_status_t;
+
+typedef struct {
+  uint8_t peer_addr[ESP_NOW_ETH_ALEN];
+  uint8_t lmk[16];
+  uint8_t channel;
+  int ifidx;
+  bool encrypt;
+  void *priv;
+} esp_now_peer_info_t;
+
+typedef void (*esp_now_recv_cb_t)(const uint8_t *mac, const uint8_t *data, int length);
+typedef void (*esp_now_send_cb_t)(const uint8_t *mac, esp_now_send_status_t status);
+
+esp_err_t esp_now_init();
+esp_err_t esp_now_deinit();
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t callback);
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t callback);
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t *peer);
+bool esp_now_is_peer_exist(const uint8_t *mac);
+esp_err_t esp_now_send(const uint8_t *mac, const uint8_t *data, size_t length);
+
+#endif
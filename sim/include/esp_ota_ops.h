@@ -0,0 +1,18 @@
+#ifndef SIM_ESP_OTA_OPS_H
+#define SIM_ESP_OTA_OPS_H
+
+// OTA writes go to the simulated app1 partition, the boot partition is logged and kept in simBootPartition (sim.h)
+
+#include <esp_partition.h>
+
+typedef uint32_t esp_ota_handle_t;
+
+const esp_partition_t *esp_ota_get_running_partition();
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start);
+esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t imageSize, esp_ota_handle_t *handle);
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size);
+esp_err_t esp_ota_end(esp_ota_handle_t handle);
+esp_err_t esp_ota_abort(esp_ota_handle_t handle);
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition);
+
+#endif
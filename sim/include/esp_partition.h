@@ -0,0 +1,25 @@
+#ifndef SIM_ESP_PARTITION_H
+#define SIM_ESP_PARTITION_H
+
+// Flash partitions of partitions.csv kept in RAM: erased to 0xFF, writes can only clear bits
+// like NOR flash. The contents start erased on every run.
+
+#include <Arduino.h>
+
+typedef enum { ESP_PARTITION_TYPE_APP, ESP_PARTITION_TYPE_DATA } esp_partition_type_t;
+typedef int esp_partition_subtype_t;
+
+typedef struct {
+  esp_partition_type_t type;
+  esp_partition_subtype_t subtype;
+  uint32_t address;
+  uint32_t size;
+  char label[17];
+} esp_partition_t;
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label);
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t offset, void *data, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t offset, const void *data, size_t size);
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef SIM_ESP_ROM_CRC_H
+#define SIM_ESP_ROM_CRC_H
+
+#include <stdint.h>
+
+// Same CRC-32 (IEEE, reflected) as the ESP32 ROM
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *data, uint32_t length);
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef SIM_ESP_TIMER_H
+#define SIM_ESP_TIMER_H
+
+#include <Arduino.h>  // esp_timer_get_time() runs on the virtual clock
+
+#endif
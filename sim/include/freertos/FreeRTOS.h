@@ -0,0 +1,36 @@
+#ifndef SIM_FREERTOS_H
+#define SIM_FREERTOS_H
+
+// Single-threaded simulator: critical sections do nothing, queues are plain FIFOs
+
+#include <stdint.h>
+
+typedef void *TaskHandle_t;
+typedef void *QueueHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define portMAX_DELAY 0xffffffff
+#define pdMS_TO_TICKS(ms) (ms)
+
+typedef struct {
+  int unused;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portENTER_CRITICAL_SAFE(mux) ((void)(mux))
+#define portEXIT_CRITICAL_SAFE(mux) ((void)(mux))
+
+TaskHandle_t xTaskGetHandle(const char *name);  // Always nullptr: there are no other tasks
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait);
+
+#endif
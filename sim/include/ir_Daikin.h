@@ -0,0 +1,37 @@
+#ifndef SIM_IR_DAIKIN_H
+#define SIM_IR_DAIKIN_H
+
+#include <IRremoteESP8266.h>
+
+// Mode and fan values as in IRremoteESP8266
+const uint8_t kDaikin64Dry = 0b001;
+const uint8_t kDaikin64Cool = 0b010;
+const uint8_t kDaikin64Fan = 0b100;
+const uint8_t kDaikin64Heat = 0b1000;
+const uint8_t kDaikin64FanAuto = 0b0001;
+const uint8_t kDaikin64FanLow = 0b1000;
+const uint8_t kDaikin64FanMed = 0b0100;
+const uint8_t kDaikin64FanHigh = 0b0010;
+const uint8_t kDaikin64FanQuiet = 0b1001;
+const uint8_t kDaikin64FanTurbo = 0b0011;
+
+// Keeps the settings in a 64-bit state (simulator layout, one byte per setting)
+class IRDaikin64 {
+ public:
+  explicit IRDaikin64(uint16_t, bool = false, bool = true) {}
+  void begin() {}
+  void setTemp(uint8_t temp) { setByte(0, temp); }
+  void setMode(uint8_t mode) { setByte(1, mode); }
+  void setFan(uint8_t fan) { setByte(2, fan); }
+  void setSwingVertical(bool swing) { setByte(3, swing); }
+  void setPowerToggle(bool toggle) { setByte(4, toggle); }
+  uint64_t getRaw() const { return state; }
+
+ private:
+  void setByte(uint8_t index, uint8_t value) {
+    state = (state & ~(0xFFULL << (index * 8))) | ((uint64_t)value << (index * 8));
+  }
+  uint64_t state = 0;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef SIM_IR_SHARP_H
+#define SIM_IR_SHARP_H
+
+#include <IRremoteESP8266.h>
+
+// Mode and fan values as in IRremoteESP8266
+const uint8_t kSharpAcAuto = 0b000;
+const uint8_t kSharpAcDry = 0b011;
+const uint8_t kSharpAcCool = 0b010;
+const uint8_t kSharpAcHeat = 0b001;
+const uint8_t kSharpAcFan = 0b100;
+const uint8_t kSharpAcFanAuto = 0b010;
+const uint8_t kSharpAcFanMin = 0b100;
+const uint8_t kSharpAcFanMed = 0b011;
+const uint8_t kSharpAcFanHigh = 0b101;
+const uint8_t kSharpAcFanMax = 0b111;
+
+// Keeps the settings in a 13-byte state (simulator layout, not the protocol's bit layout)
+class IRSharpAc {
+ public:
+  explicit IRSharpAc(uint16_t, bool = false, bool = true) {}
+  void begin() {}
+  void on() { state[1] = 1; }
+  void off() { state[1] = 0; }
+  void setTemp(uint8_t temp, bool = true) { state[2] = temp; }
+  uint8_t getTemp() const { return state[2]; }
+  void setMode(uint8_t mode, bool = true) { state[3] = mode; }
+  void setFan(uint8_t fan, bool = true) { state[4] = fan; }
+  void setSwingToggle(bool toggle) { state[5] = toggle; }
+  uint8_t *getRaw() {
+    state[0] = 0xAA;
+    state[kSharpAcStateLength - 1] = 0;
+    for (uint8_t i = 0; i < kSharpAcStateLength - 1; i++) state[kSharpAcStateLength - 1] ^= state[i];
+    return state;
+  }
+
+ private:
+  uint8_t state[kSharpAcStateLength] = {};
+};
+
+#endif
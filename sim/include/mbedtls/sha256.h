@@ -0,0 +1,21 @@
+#ifndef SIM_MBEDTLS_SHA256_H
+#define SIM_MBEDTLS_SHA256_H
+
+// SHA-256 for the delta OTA image checks (sim_platform.cpp), SHA-224 is not supported
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+  uint64_t length;  // Bytes hashed so far
+  uint32_t state[8];
+  uint8_t buffer[64];
+} mbedtls_sha256_context;
+
+void mbedtls_sha256_init(mbedtls_sha256_context *context);
+void mbedtls_sha256_free(mbedtls_sha256_context *context);
+int mbedtls_sha256_starts(mbedtls_sha256_context *context, int is224);
+int mbedtls_sha256_update(mbedtls_sha256_context *context, const unsigned char *input, size_t length);
+int mbedtls_sha256_finish(mbedtls_sha256_context *context, unsigned char output[32]);
+
+#endif
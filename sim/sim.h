@@ -0,0 +1,100 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <Arduino.h>
+#include <esp_partition.h>
+
+#include <string>
+#include <vector>
+
+// Deterministic simulator (pio run -e sim, see sim_main.cpp)
+// The firmware in src/ runs unchanged on the host against the fake libraries in sim/include.
+// Time only moves when the simulator advances it, so a run gives the same trace every time and
+// hours of simulated use take seconds.
+// The host tests in test/ (pio test -e sim) link the same firmware and simulator without
+// sim_main.cpp's main() and drive the modules directly through this interface.
+
+// Virtual clock
+uint64_t simNowUs();
+void simAdvanceUs(uint64_t us);
+
+// Trace: one line per event, prefixed with the virtual time and the time since the last input
+void simTrace(const char *format, ...) __attribute__((format(printf, 1, 2)));
+extern bool simQuiet;  // Suppresses the trace
+void simMarkInput();  // Called for every replayed encoder, button, serial or ESP-NOW event
+uint64_t simLastInputUs();
+
+// Inputs
+const uint8_t SIM_PIN_COUNT = 40;
+extern uint8_t simPinLevel[SIM_PIN_COUNT];  // GPIO input levels, HIGH until an event changes them
+extern uint8_t simPinOutput[SIM_PIN_COUNT];  // Last digitalWrite() level of each pin
+void simSerialInput(const char *line);      // Queue a line (with newline) for Serial.read()
+void simEspNowReceive(const uint8_t *data, int length);
+
+// ESP-NOW loopback: with a peer installed, packets the remote sends to the receiver address are handed
+// to it right away. Packets the peer sends while it handles one reach the remote's receive callback
+// (and are dropped while the remote's radio is off).
+typedef void (*SimEspNowPeer)(const uint8_t *mac, const uint8_t *data, int length);
+extern SimEspNowPeer simEspNowPeer;
+extern const uint8_t SIM_REMOTE_MAC[6];                                      // Sender address the peer sees
+void simEspNowPeerReceive(const uint8_t *mac, const uint8_t *data, int length);  // Packet from another device
+
+// Outputs recorded for the expectations, all of them with their virtual time
+enum SimEventType : uint8_t { SIM_IR, SIM_ESPNOW, SIM_FRAME, SIM_SLEEP, SIM_SERIAL_OUT };
+
+struct SimEvent {
+  SimEventType type;
+  uint64_t timeUs;
+  uint64_t sinceInputUs;  // Time since the last input event
+  std::string detail;     // IR: appliance name, frame: the text on the screen, serial: the line written
+};
+
+void simRecord(SimEventType type, const std::string &detail);
+extern std::vector<SimEvent> simEvents;  // Everything recorded since the start (tests may clear it)
+int simCountEvents(SimEventType type, const char *prefix = "");  // Events whose detail starts with prefix
+extern bool simDisplayOn;
+extern uint64_t simFrameRenderNs;  // Host time from clearBuffer() to sendBuffer(), summed over simFrameRenders
+extern uint32_t simFrameRenders;
+
+// RMT transmissions (sim_ir.cpp): every rmt_write_items() call with the pin and carrier of its channel
+struct SimRmtFrame {
+  uint8_t channel;
+  uint8_t pin;
+  bool carrier;
+  uint64_t startUs;
+  uint64_t endUs;
+  std::vector<uint32_t> timings;  // Mark/space durations (us) rebuilt from the items, starting with a mark
+};
+extern std::vector<SimRmtFrame> simRmtFrames;
+
+// Sleep
+extern esp_sleep_wakeup_cause_t simWakeupCause;  // Returned by esp_sleep_get_wakeup_cause()
+extern uint64_t simSleepTimerUs;                 // Last esp_sleep_enable_timer_wakeup() value, 0 when not armed
+
+// Flash partitions (RAM-backed, erased on every run)
+extern int64_t simFlashBudget;  // Bytes that can still be erased or programmed before a power cut, -1 = no cut
+extern uint32_t simFlashReads;  // esp_partition_read() calls
+extern uint32_t simFlashBytesWritten;
+extern uint32_t simFlashSectorErases;
+extern bool simFlashWriteFails;                  // esp_partition_write() and esp_ota_write() return ESP_FAIL
+extern const esp_partition_t *simBootPartition;  // Set by esp_ota_set_boot_partition(), app0 at start
+
+// Network stand-ins (sim_radio.cpp, sim_websocket.cpp), off by default
+extern bool simWifiAccessPoint;  // An access point is in range: the station joins simWifiJoinUs after WiFi.begin()
+extern uint64_t simWifiJoinUs;
+extern bool simWsServerUp;       // The WebSocket server accepts connections
+extern uint64_t simWsLatencyUs;  // Round trip to the server, for the handshake and every request
+extern bool simWsServerAnswers;  // false: requests arrive but are never answered
+extern std::vector<std::vector<uint8_t>> simWsRequests;  // Binary frames received by the server, in order
+extern uint8_t simWsSwitchState[4];                      // Switch states kept by the server
+void simWsPush(const std::vector<uint8_t> &frame);       // Server -> remote message, delivered on the next loop
+
+// Thrown by esp_deep_sleep_start(), esp_restart() and a power cut to end the run
+struct SimStop {
+  const char *reason;
+};
+
+void simInstallIrCapture();  // Logs every IR command the firmware queues (sim_ir.cpp)
+void simInstallRenderCacheHook();  // Keeps render cache hits in the text list of the frames (sim_display.cpp)
+
+#endif
@@ -0,0 +1,176 @@
+// SH1106 display for the simulator: page buffer for the graphics, display list for the text
+
+#include <U8g2lib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "render_cache.h"
+#include "sim.h"
+
+// {glyph width, max char height, y offset (signed)}
+const uint8_t u8g2_font_spleen8x16_mr[] = {8, 16, (uint8_t)-4};
+const uint8_t u8g2_font_spleen6x12_mr[] = {6, 12, (uint8_t)-2};
+const uint8_t u8g2_font_minuteconsole_mr[] = {5, 7, (uint8_t)-1};
+const uint8_t u8g2_font_4x6_tr[] = {4, 6, (uint8_t)-1};
+const uint8_t u8g2_font_6x13_tr[] = {6, 13, (uint8_t)-2};
+const uint8_t u8g2_font_profont29_tr[] = {16, 29, (uint8_t)-6};
+const uint8_t u8g2_font_profont11_tr[] = {6, 11, (uint8_t)-2};
+
+struct SimText {
+  int x;
+  int y;  // Baseline
+  std::string text;
+  bool inverted;  // Drawn in color 0 or under an XOR box
+};
+
+struct SimBox {
+  int x, y, width, height;
+};
+
+std::vector<SimText> simTexts;
+std::vector<SimBox> simXorBoxes;
+std::string simLastFrame;
+bool simDisplayOn = true;
+const char *simCacheText = nullptr;  // String the render cache is about to draw
+uint64_t simFrameRenderNs = 0;
+uint32_t simFrameRenders = 0;
+std::chrono::steady_clock::time_point simFrameStart;
+
+bool U8G2::begin() {
+  clearBuffer();
+  return true;
+}
+
+void U8G2::clearBuffer() {
+  simFrameStart = std::chrono::steady_clock::now();
+  memset(buffer, 0, sizeof(buffer));
+  simTexts.clear();
+  simXorBoxes.clear();
+}
+
+void U8G2::setPowerSave(uint8_t enable) {
+  if (simDisplayOn == !enable) return;
+  simDisplayOn = !enable;
+  simTrace("display %s", simDisplayOn ? "on" : "off");
+}
+
+void U8G2::setFont(const uint8_t *font) {
+  state.font = font;
+  state.font_info.max_char_height = font[1];
+  state.font_info.y_offset = (int8_t)font[2];
+}
+
+uint16_t U8G2::getStrWidth(const char *text) { return strlen(text) * state.font[0]; }
+
+// Cache hits never call drawStr(), the cache reports every string here instead. A miss then renders
+// the same string off position with drawStr(), which must not show up in the text list.
+void simCachedText(int x, int y, const char *text) {
+  simTexts.push_back({x, y, text, u8g2.getDrawColor() == 0});
+  simCacheText = text;
+}
+
+void simInstallRenderCacheHook() { renderCacheHook = simCachedText; }
+
+// Placeholder glyph: a fixed pattern per character, with a blank column on the right
+bool glyphPixel(char c, int column, int row) {
+  uint32_t hash = ((uint8_t)c * 2654435761u) ^ (column * 40503u) ^ (row * 2246822519u);
+  return (hash >> 13) & 1;
+}
+
+// Glyphs are drawn in transparent mode like U8g2 does, so the pixel hash and the render cache see the text
+uint16_t U8G2::drawStr(int x, int y, const char *text) {
+  bool fromCache = text == simCacheText;
+  simCacheText = nullptr;
+  if (!fromCache) simTexts.push_back({x, y, text, drawColor == 0});
+
+  int width = state.font[0];
+  int top = y - getAscent();
+  for (const char *c = text; *c != '\0'; c++, x += width) {
+    if (*c == ' ') continue;
+    for (int row = 0; row < state.font_info.max_char_height; row++) {
+      for (int column = 0; column < width - 1; column++) {
+        if (glyphPixel(*c, column, row)) drawPixel(x + column, top + row);
+      }
+    }
+  }
+  return getStrWidth(text);
+}
+
+size_t U8G2::write(uint8_t c) {
+  char text[2] = {(char)c, '\0'};
+  cursorX += drawStr(cursorX, cursorY, text);
+  return 1;
+}
+
+void U8G2::drawPixel(int x, int y) {
+  if (x < 0 || x >= 128 || y < 0 || y >= 64) return;
+  uint8_t &byte = buffer[(y / 8) * 128 + x];
+  uint8_t mask = 1 << (y % 8);
+  if (drawColor == 0) byte &= ~mask;
+  else if (drawColor == 1) byte |= mask;
+  else byte ^= mask;
+}
+
+void U8G2::drawHLine(int x, int y, int width) {
+  for (int i = 0; i < width; i++) drawPixel(x + i, y);
+}
+
+void U8G2::drawVLine(int x, int y, int height) {
+  for (int i = 0; i < height; i++) drawPixel(x, y + i);
+}
+
+void U8G2::drawBox(int x, int y, int width, int height) {
+  for (int i = 0; i < height; i++) drawHLine(x, y + i, width);
+  if (drawColor == 2) simXorBoxes.push_back({x, y, width, height});
+}
+
+void U8G2::drawFrame(int x, int y, int width, int height) {
+  drawHLine(x, y, width);
+  drawHLine(x, y + height - 1, width);
+  drawVLine(x, y + 1, height - 2);
+  drawVLine(x + width - 1, y + 1, height - 2);
+}
+
+// XBM: rows of LSB-first bytes, transparent background (bitmap mode 1)
+void U8G2::drawXBMP(int x, int y, int width, int height, const uint8_t *bitmap) {
+  int rowBytes = (width + 7) / 8;
+  for (int row = 0; row < height; row++) {
+    for (int column = 0; column < width; column++) {
+      if (bitmap[row * rowBytes + column / 8] & (1 << (column % 8))) drawPixel(x + column, y + row);
+    }
+  }
+}
+
+// Text rows from top to bottom joined with " | ", highlighted text as >text<, then a hash of the pixels
+std::string describeFrame(const uint8_t *buffer) {
+  for (SimText &text : simTexts) {
+    for (const SimBox &box : simXorBoxes) {
+      if (text.x >= box.x && text.x < box.x + box.width && text.y - 1 >= box.y && text.y - 1 < box.y + box.height) text.inverted = !text.inverted;
+    }
+  }
+  std::stable_sort(simTexts.begin(), simTexts.end(), [](const SimText &a, const SimText &b) { return a.y != b.y ? a.y < b.y : a.x < b.x; });
+
+  std::string frame;
+  for (size_t i = 0; i < simTexts.size(); i++) {
+    if (i > 0) frame += simTexts[i].y == simTexts[i - 1].y ? " " : " | ";
+    frame += simTexts[i].inverted ? ">" + simTexts[i].text + "<" : simTexts[i].text;
+  }
+
+  uint32_t hash = 2166136261u;  // FNV-1a
+  for (int i = 0; i < 128 * 8; i++) hash = (hash ^ buffer[i]) * 16777619u;
+  char pixels[16];
+  snprintf(pixels, sizeof(pixels), " #%08x", hash);
+  return frame + pixels;
+}
+
+// Only frames that differ from the previous one are recorded
+void U8G2::sendBuffer() {
+  simFrameRenderNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - simFrameStart).count();
+  simFrameRenders++;
+  std::string frame = describeFrame(buffer);
+  if (frame == simLastFrame) return;
+  simLastFrame = frame;
+  simRecord(SIM_FRAME, frame);
+}
@@ -0,0 +1,74 @@
+// RMT transmitter timing and IR frame capture for the simulator
+
+#include <driver/rmt.h>
+
+#include "ir_emitter.h"
+#include "sim.h"
+
+uint64_t simRmtBusyUntilUs[RMT_CHANNEL_MAX];
+uint8_t simRmtPin[RMT_CHANNEL_MAX];
+bool simRmtCarrier[RMT_CHANNEL_MAX];
+std::vector<SimRmtFrame> simRmtFrames;
+
+esp_err_t rmt_config(const rmt_config_t *config) {
+  simRmtPin[config->channel] = config->gpio_num;
+  simRmtCarrier[config->channel] = config->tx_config.carrier_en;
+  return ESP_OK;
+}
+esp_err_t rmt_driver_install(rmt_channel_t, size_t, int) { return ESP_OK; }
+esp_err_t rmt_driver_uninstall(rmt_channel_t) { return ESP_OK; }
+esp_err_t rmt_set_tx_carrier(rmt_channel_t channel, bool enable, uint16_t, uint16_t, rmt_carrier_level_t) {
+  simRmtCarrier[channel] = enable;
+  return ESP_OK;
+}
+
+// Appends one item half, merging it with the previous duration when the level did not change
+void addRmtHalf(SimRmtFrame &frame, uint32_t level, uint32_t duration) {
+  if (duration == 0) return;
+  bool lastIsMark = frame.timings.size() % 2 == 1;
+  if (!frame.timings.empty() && lastIsMark == (level == 1)) {
+    frame.timings.back() += duration;
+  } else if (!frame.timings.empty() || level == 1) {
+    frame.timings.push_back(duration);
+  }
+}
+
+// The channel is busy for the sum of the item durations (1 tick = 1 us with clk_div 80)
+esp_err_t rmt_write_items(rmt_channel_t channel, const rmt_item32_t *items, int itemCount, bool waitDone) {
+  SimRmtFrame frame = {(uint8_t)channel, simRmtPin[channel], simRmtCarrier[channel], max(simRmtBusyUntilUs[channel], simNowUs()), 0, {}};
+  uint64_t durationUs = 0;
+  for (int i = 0; i < itemCount; i++) {
+    durationUs += items[i].duration0 + items[i].duration1;
+    addRmtHalf(frame, items[i].level0, items[i].duration0);
+    addRmtHalf(frame, items[i].level1, items[i].duration1);
+  }
+  simRmtBusyUntilUs[channel] = frame.startUs + durationUs;
+  frame.endUs = simRmtBusyUntilUs[channel];
+  simRmtFrames.push_back(frame);
+  return waitDone ? rmt_wait_tx_done(channel, portMAX_DELAY) : ESP_OK;
+}
+
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, TickType_t wait) {
+  if (simNowUs() >= simRmtBusyUntilUs[channel]) return ESP_OK;
+  if (wait == 0) return ESP_ERR_TIMEOUT;
+  simAdvanceUs(simRmtBusyUntilUs[channel] - simNowUs());  // Only portMAX_DELAY is used
+  return ESP_OK;
+}
+
+const char *const SIM_APPLIANCE_NAMES[IR_APPLIANCE_COUNT] = {"deka", "fft", "lg", "astro", "sharp", "daikin"};
+const char *const SIM_PROTOCOL_NAMES[] = {"NEC", "RC6", "SYMPHONY", "SHARP_AC", "DAIKIN64"};
+
+// Returns false: the command is still queued and transmitted, so the RMT timing stays real
+bool simCaptureIr(IrAppliance appliance, const IrCommand &command) {
+  char text[80];
+  int length = snprintf(text, sizeof(text), "%s %s ", SIM_APPLIANCE_NAMES[appliance], SIM_PROTOCOL_NAMES[command.protocol]);
+  if (command.nbytes == 0) {
+    snprintf(text + length, sizeof(text) - length, "0x%llx/%u", (unsigned long long)command.data, command.nbits);
+  } else {
+    for (uint8_t i = 0; i < command.nbytes; i++) length += snprintf(text + length, sizeof(text) - length, "%02x", command.state[i]);
+  }
+  simRecord(SIM_IR, text);
+  return false;
+}
+
+void simInstallIrCapture() { irCaptureHook = simCaptureIr; }
@@ -0,0 +1,359 @@
+// Deterministic simulator: replays a scenario against the firmware on a virtual clock
+//
+//   pio run -e sim && .pio/build/sim/program sim/scenarios/daikin_temperature.txt
+//
+// A scenario is a text file with one event per line, '#' starts a comment:
+//
+//   <time> <command>
+//
+// <time> is absolute from boot ("10s") or relative to the end of the previous line ("+2s"), in
+// ms, s, m or h (default ms). The end of a line is its last detent or the button release.
+//
+//   turn <counts> [every <ms>]   Encoder counts, negative to turn back (default every 200 ms)
+//   trace <file> [reverse]       Replay a recorded rotation (path relative to the scenario), reversed
+//                                to turn the other way. One "<time since the previous change> <counts>"
+//                                per line, as logged by DEBUG_ENCODER in main.cpp.
+//   press [<ms>]                 Press the select button and release it after <ms> (default 50)
+//   serial <line>                Type a line on the serial port
+//   espnow <hex>                 Receive an ESP-NOW packet from the receiver
+//   otakey <hex>                 Accept delta updates signed with this key (64 hex digits), from boot
+//   mark                         Start counting IR frames and ESP-NOW packets again
+//   expect ir <appliance|any> <count> [<min>..<max>]
+//                                IR frames since the mark; with a range, each of them must be sent
+//                                <min> to <max> ms after the input that preceded it
+//   expect espnow <count>        ESP-NOW packets sent since the mark
+//   expect text <text>           The current frame shows <text>
+//   expect display on|off
+//   expect sleep                 The remote went to deep sleep by now (this ends every run)
+//   end                          Keep running until this time
+//
+// The trace lists every input, frame change, IR frame, ESP-NOW packet and serial line with its
+// virtual time. The exit status is 1 when an expectation failed, 2 when the scenario is invalid.
+
+#include <Arduino.h>
+
+#include <chrono>
+#include <vector>
+
+#include "sim.h"
+
+void setup();
+void loop();
+
+const uint64_t SIM_LOOP_US = 1000;  // Virtual time per loop() iteration (on top of its own delays)
+const int SIM_SELECT_BUTTON = 32;   // SELECT_BUTTON in main.cpp
+
+extern uint8_t deltaOtaKey[32];     // delta_ota.cpp, all zeros (updates refused) in the firmware
+
+int64_t simEncoderCount = 0;
+
+/*=================================== TRACE ===================================*/
+bool simQuiet = false;
+uint64_t simInputUs = 0;
+std::vector<SimEvent> simEvents;
+
+void simTrace(const char *format, ...) {
+  if (simQuiet) return;
+  char text[1024];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  printf("%12.3f  %s\n", simNowUs() / 1e6, text);
+}
+
+void simMarkInput() { simInputUs = simNowUs(); }
+uint64_t simLastInputUs() { return simInputUs; }
+
+const char *const SIM_EVENT_NAMES[] = {"ir", "espnow >", "frame", "deep sleep", "serial <"};
+
+void simRecord(SimEventType type, const std::string &detail) {
+  SimEvent event = {type, simNowUs(), simNowUs() - simInputUs, detail};
+  simEvents.push_back(event);
+  if (type == SIM_FRAME) simTrace("%s %s", SIM_EVENT_NAMES[type], detail.c_str());
+  else simTrace("%s %s (+%.3f s after input)", SIM_EVENT_NAMES[type], detail.c_str(), event.sinceInputUs / 1e6);
+}
+
+int simCountEvents(SimEventType type, const char *prefix) {
+  int count = 0;
+  for (const SimEvent &event : simEvents) count += event.type == type && event.detail.compare(0, strlen(prefix), prefix) == 0;
+  return count;
+}
+
+/*=================================== SCENARIO ===================================*/
+enum SimActionType : uint8_t { SIM_TURN, SIM_PRESS, SIM_RELEASE, SIM_SERIAL, SIM_ESPNOW_RX, SIM_MARK, SIM_EXPECT, SIM_END };
+
+struct SimAction {
+  uint64_t timeUs;
+  SimActionType type;
+  int value;         // Turn direction
+  std::string text;  // Serial line, packet bytes or the expectation
+  int line;
+};
+
+std::vector<SimAction> simActions;
+const char *simScenarioName = "";
+
+[[noreturn]] void scenarioError(int line, const char *message) {
+  fprintf(stderr, "%s:%d: %s\n", simScenarioName, line, message);
+  exit(2);
+}
+
+// "1.5s", "+200ms", "3m" or "1h" in us; plain numbers are ms
+uint64_t parseDuration(const char *text, int line) {
+  char *end;
+  double value = strtod(text, &end);
+  if (end == text || value < 0) scenarioError(line, "invalid time");
+  if (strcmp(end, "") == 0 || strcmp(end, "ms") == 0) return value * 1000;
+  if (strcmp(end, "s") == 0) return value * 1000000;
+  if (strcmp(end, "m") == 0) return value * 60000000;
+  if (strcmp(end, "h") == 0) return value * 3600000000.0;
+  scenarioError(line, "unknown time unit");
+}
+
+std::string trim(const std::string &text) {
+  size_t start = text.find_first_not_of(" \t\r\n");
+  if (start == std::string::npos) return "";
+  return text.substr(start, text.find_last_not_of(" \t\r\n") - start + 1);
+}
+
+// Queues the count changes of a trace file from startUs and returns the time of the last one
+uint64_t loadTrace(const char *path, bool reverse, uint64_t startUs, int scenarioLine) {
+  FILE *file = fopen(path, "r");
+  if (file == nullptr) scenarioError(scenarioLine, "cannot open the trace");
+
+  char buffer[128];
+  uint64_t timeUs = startUs;
+  int changes = 0;
+  while (fgets(buffer, sizeof(buffer), file) != nullptr) {
+    std::string text = buffer;
+    if (text.find('#') != std::string::npos) text = text.substr(0, text.find('#'));
+    text = trim(text);
+    if (text.empty()) continue;
+
+    char delay[32];
+    int counts = 0;
+    if (sscanf(text.c_str(), "%31s %d", delay, &counts) != 2 || counts == 0) scenarioError(scenarioLine, "trace lines are <time> <counts>");
+    timeUs += parseDuration(delay, scenarioLine);
+    simActions.push_back({timeUs, SIM_TURN, reverse ? -counts : counts, "", scenarioLine});
+    changes++;
+  }
+  fclose(file);
+  if (changes == 0) scenarioError(scenarioLine, "empty trace");
+  return timeUs;
+}
+
+void loadScenario(const char *path) {
+  FILE *file = fopen(path, "r");
+  if (file == nullptr) {
+    fprintf(stderr, "Cannot open %s\n", path);
+    exit(2);
+  }
+  simScenarioName = path;
+
+  char buffer[512];
+  int line = 0;
+  uint64_t previousEndUs = 0;
+  while (fgets(buffer, sizeof(buffer), file) != nullptr) {
+    line++;
+    std::string text = buffer;
+    if (text.find('#') != std::string::npos) text = text.substr(0, text.find('#'));
+    text = trim(text);
+    if (text.empty()) continue;
+
+    size_t space = text.find(' ');
+    std::string timeText = text.substr(0, space);
+    std::string command = space == std::string::npos ? "" : trim(text.substr(space));
+    std::string argument = command.find(' ') == std::string::npos ? "" : trim(command.substr(command.find(' ')));
+    std::string verb = command.substr(0, command.find(' '));
+
+    uint64_t timeUs = timeText[0] == '+' ? previousEndUs + parseDuration(timeText.c_str() + 1, line) : parseDuration(timeText.c_str(), line);
+    previousEndUs = timeUs;
+
+    if (verb == "turn") {
+      int counts = 0;
+      double every = 200;
+      if (sscanf(argument.c_str(), "%d every %lf", &counts, &every) < 1 || counts == 0 || every <= 0) scenarioError(line, "usage: turn <counts> [every <ms>]");
+      for (int i = 0; i < abs(counts); i++) {
+        previousEndUs = timeUs + (uint64_t)(i * every * 1000);
+        simActions.push_back({previousEndUs, SIM_TURN, counts > 0 ? 1 : -1, "", line});
+      }
+    } else if (verb == "trace") {
+      std::string tracePath = argument.substr(0, argument.find(' '));
+      bool reverse = argument.find(' ') != std::string::npos && trim(argument.substr(argument.find(' '))) == "reverse";
+      std::string scenarioPath = path;
+      if (scenarioPath.find('/') != std::string::npos) tracePath = scenarioPath.substr(0, scenarioPath.rfind('/') + 1) + tracePath;
+      previousEndUs = loadTrace(tracePath.c_str(), reverse, timeUs, line);
+    } else if (verb == "press") {
+      uint64_t holdUs = argument.empty() ? 50000 : parseDuration(argument.c_str(), line);
+      simActions.push_back({timeUs, SIM_PRESS, 0, "", line});
+      previousEndUs = timeUs + holdUs;
+      simActions.push_back({previousEndUs, SIM_RELEASE, 0, "", line});
+    } else if (verb == "serial") {
+      simActions.push_back({timeUs, SIM_SERIAL, 0, argument, line});
+    } else if (verb == "espnow") {
+      std::string bytes;
+      for (size_t i = 0; i + 1 < argument.size(); i += 2) bytes += (char)strtol(argument.substr(i, 2).c_str(), nullptr, 16);
+      if (bytes.empty() || argument.size() % 2 != 0) scenarioError(line, "usage: espnow <hex bytes>");
+      simActions.push_back({timeUs, SIM_ESPNOW_RX, 0, bytes, line});
+    } else if (verb == "otakey") {
+      if (argument.size() != 64 || argument.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) scenarioError(line, "usage: otakey <64 hex digits>");
+      for (int i = 0; i < 32; i++) deltaOtaKey[i] = strtol(argument.substr(2 * i, 2).c_str(), nullptr, 16);
+    } else if (verb == "mark") {
+      simActions.push_back({timeUs, SIM_MARK, 0, "", line});
+    } else if (verb == "expect") {
+      simActions.push_back({timeUs, SIM_EXPECT, 0, argument, line});
+    } else if (verb == "end") {
+      simActions.push_back({timeUs, SIM_END, 0, "", line});
+    } else {
+      scenarioError(line, "unknown command");
+    }
+  }
+  fclose(file);
+
+  std::stable_sort(simActions.begin(), simActions.end(), [](const SimAction &a, const SimAction &b) { return a.timeUs < b.timeUs; });
+}
+
+/*=================================== EXPECTATIONS ===================================*/
+size_t simMarkIndex = 0;  // First event counted by the expectations
+const char *simStopReason = nullptr;
+int simPassed = 0;
+int simFailed = 0;
+
+// Returns an empty string when the expectation holds, otherwise what was found instead
+std::string checkExpectation(const SimAction &action) {
+  char found[160] = "";
+  if (action.timeUs > simNowUs()) {  // The run stopped before this line
+    if (action.text == "sleep") return "";
+    snprintf(found, sizeof(found), "the run stopped by %s at %.3f s", simStopReason, simNowUs() / 1e6);
+    return found;
+  }
+  char name[32] = "";
+  int count = -1;
+  double minMs = 0, maxMs = 0;
+  const char *text = action.text.c_str();
+
+  if (sscanf(text, "ir %31s %d %lf..%lf", name, &count, &minMs, &maxMs) >= 2) {
+    bool ranged = sscanf(text, "ir %*s %*d %lf..%lf", &minMs, &maxMs) == 2;
+    int matched = 0;
+    for (size_t i = simMarkIndex; i < simEvents.size(); i++) {
+      const SimEvent &event = simEvents[i];
+      if (event.type != SIM_IR || (strcmp(name, "any") != 0 && event.detail.compare(0, strlen(name) + 1, std::string(name) + " ") != 0)) continue;
+      matched++;
+      double delayMs = event.sinceInputUs / 1000.0;
+      if (ranged && (delayMs < minMs || delayMs > maxMs)) snprintf(found, sizeof(found), "frame %.3f ms after input", delayMs);
+    }
+    if (found[0] != '\0') return found;
+    if (matched != count) snprintf(found, sizeof(found), "%d frames", matched);
+  } else if (sscanf(text, "espnow %d", &count) == 1) {
+    int matched = 0;
+    for (size_t i = simMarkIndex; i < simEvents.size(); i++) matched += simEvents[i].type == SIM_ESPNOW;
+    if (matched != count) snprintf(found, sizeof(found), "%d packets", matched);
+  } else if (strncmp(text, "text ", 5) == 0) {
+    std::string frame;
+    for (const SimEvent &event : simEvents) {
+      if (event.type == SIM_FRAME) frame = event.detail;
+    }
+    if (frame.find(text + 5) == std::string::npos) snprintf(found, sizeof(found), "frame \"%.120s\"", frame.c_str());
+  } else if (strcmp(text, "display on") == 0 || strcmp(text, "display off") == 0) {
+    if (simDisplayOn != (strcmp(text, "display on") == 0)) snprintf(found, sizeof(found), "display %s", simDisplayOn ? "on" : "off");
+  } else if (strcmp(text, "sleep") == 0) {
+    if (simStopReason == nullptr) snprintf(found, sizeof(found), "still awake");
+  } else {
+    scenarioError(action.line, "unknown expectation");
+  }
+  return found;
+}
+
+void runExpectation(const SimAction &action) {
+  std::string failure = checkExpectation(action);
+  if (failure.empty()) {
+    simPassed++;
+    simTrace("PASS line %d: expect %s", action.line, action.text.c_str());
+  } else {
+    simFailed++;
+    printf("%12.3f  FAIL %s:%d: expect %s, found %s\n", action.timeUs / 1e6, simScenarioName, action.line, action.text.c_str(), failure.c_str());
+  }
+}
+
+/*=================================== RUN ===================================*/
+void applyAction(const SimAction &action) {
+  switch (action.type) {
+    case SIM_TURN:
+      simEncoderCount += action.value;
+      simMarkInput();
+      simTrace("turn %+d (count %lld)", action.value, (long long)simEncoderCount);
+      break;
+    case SIM_PRESS:
+      simPinLevel[SIM_SELECT_BUTTON] = LOW;
+      simMarkInput();
+      simTrace("press");
+      break;
+    case SIM_RELEASE:
+      simPinLevel[SIM_SELECT_BUTTON] = HIGH;
+      simTrace("release");
+      break;
+    case SIM_SERIAL:
+      simSerialInput(action.text.c_str());
+      simMarkInput();
+      simTrace("serial > %s", action.text.c_str());
+      break;
+    case SIM_ESPNOW_RX:
+      simMarkInput();
+      simEspNowReceive((const uint8_t *)action.text.data(), action.text.size());
+      break;
+    case SIM_MARK:
+      simMarkIndex = simEvents.size();
+      simTrace("mark");
+      break;
+    case SIM_EXPECT:
+      runExpectation(action);
+      break;
+    case SIM_END:
+      break;
+  }
+}
+
+#ifndef PIO_UNIT_TESTING  // The tests in test/ have their own main()
+int main(int argc, char **argv) {
+  int argument = 1;
+  if (argument < argc && strcmp(argv[argument], "-q") == 0) {
+    simQuiet = true;
+    argument++;
+  }
+  if (argument != argc - 1) {
+    fprintf(stderr, "Usage: %s [-q] <scenario>\n", argv[0]);
+    return 2;
+  }
+  loadScenario(argv[argument]);
+
+  auto wallStart = std::chrono::steady_clock::now();
+  uint64_t loops = 0;
+  size_t next = 0;
+  simInstallIrCapture();
+  simInstallRenderCacheHook();
+  try {
+    setup();
+    while (next < simActions.size()) {
+      while (next < simActions.size() && simActions[next].timeUs <= simNowUs()) applyAction(simActions[next++]);
+      loop();
+      loops++;
+      simAdvanceUs(SIM_LOOP_US);
+    }
+  } catch (const SimStop &stop) {
+    simStopReason = stop.reason;
+    simTrace("stopped by %s", stop.reason);
+  }
+  for (; next < simActions.size(); next++) {  // Left when the run stopped early
+    if (simActions[next].type == SIM_EXPECT) runExpectation(simActions[next]);
+  }
+
+  double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+  int counts[5] = {};
+  for (const SimEvent &event : simEvents) counts[event.type]++;
+  printf("Simulated %.3f s in %.3f s (%llu loops): %d IR frames, %d ESP-NOW packets, %d frames (%.1f us to render on the host). Expectations: %d passed, %d failed\n",
+         simNowUs() / 1e6, wallSeconds, (unsigned long long)loops, counts[SIM_IR], counts[SIM_ESPNOW], counts[SIM_FRAME],
+         simFrameRenders > 0 ? simFrameRenderNs / 1e3 / simFrameRenders : 0.0, simPassed, simFailed);
+  return simFailed > 0 ? 1 : 0;
+}
+#endif
@@ -0,0 +1,314 @@
+// Arduino core, FreeRTOS queues, flash partitions, OTA, CRC-32 and SHA-256 for the simulator
+
+#include <Arduino.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <esp_rom_crc.h>
+#include <mbedtls/sha256.h>
+
+#include <deque>
+#include <vector>
+
+#include "sim.h"
+
+/*=================================== CLOCK ===================================*/
+uint64_t simClockUs = 0;
+
+uint64_t simNowUs() { return simClockUs; }
+void simAdvanceUs(uint64_t us) { simClockUs += us; }
+
+unsigned long millis() { return (unsigned long)(simClockUs / 1000); }
+unsigned long micros() { return (unsigned long)simClockUs; }
+int64_t esp_timer_get_time() { return (int64_t)simClockUs; }
+void delay(unsigned long ms) { simAdvanceUs((uint64_t)ms * 1000); }
+void delayMicroseconds(unsigned int us) { simAdvanceUs(us); }
+void yield() {}
+
+/*=================================== GPIO ===================================*/
+uint8_t simPinLevel[SIM_PIN_COUNT];
+uint8_t simPinOutput[SIM_PIN_COUNT];
+
+struct SimPinDefaults {
+  SimPinDefaults() { memset(simPinLevel, HIGH, sizeof(simPinLevel)); }
+} simPinDefaults;
+
+int digitalRead(int pin) { return pin < SIM_PIN_COUNT ? simPinLevel[pin] : LOW; }
+void digitalWrite(int pin, int level) {
+  if (pin < SIM_PIN_COUNT) simPinOutput[pin] = level;
+}
+void pinMode(int, int) {}
+
+size_t simStrlcpy(char *destination, const char *source, size_t size) {
+  size_t length = strlen(source);
+  if (size > 0) {
+    size_t copied = min(length, size - 1);
+    memcpy(destination, source, copied);
+    destination[copied] = '\0';
+  }
+  return length;
+}
+
+/*=================================== SERIAL ===================================*/
+HardwareSerial Serial;
+std::deque<char> simSerialRx;
+std::string simSerialLine;
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  for (size_t i = 0; i < size; i++) write(buffer[i]);
+  return size;
+}
+
+size_t Print::printf(const char *format, ...) {
+  char text[512];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  if (length < 0) return 0;
+  return write((const uint8_t *)text, min((size_t)length, sizeof(text) - 1));
+}
+
+// Complete lines are recorded, empty ones are dropped
+size_t HardwareSerial::write(uint8_t c) {
+  if (c == '\r') return 1;
+  if (c != '\n') {
+    simSerialLine += (char)c;
+    return 1;
+  }
+  if (!simSerialLine.empty()) simRecord(SIM_SERIAL_OUT, simSerialLine);
+  simSerialLine.clear();
+  return 1;
+}
+
+int HardwareSerial::available() { return (int)simSerialRx.size(); }
+
+int HardwareSerial::read() {
+  if (simSerialRx.empty()) return -1;
+  char c = simSerialRx.front();
+  simSerialRx.pop_front();
+  return (uint8_t)c;
+}
+
+void simSerialInput(const char *line) {
+  while (*line) simSerialRx.push_back(*line++);
+  simSerialRx.push_back('\n');
+}
+
+/*=================================== SLEEP ===================================*/
+esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t, int) { return ESP_OK; }
+
+esp_sleep_wakeup_cause_t simWakeupCause = ESP_SLEEP_WAKEUP_UNDEFINED;  // Cold boot unless a test changes it
+uint64_t simSleepTimerUs = 0;
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t us) {
+  simSleepTimerUs = us;
+  simTrace("sleep timer %.3f s", us / 1e6);
+  return ESP_OK;
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() { return simWakeupCause; }
+
+void esp_deep_sleep_start() {
+  simRecord(SIM_SLEEP, "");
+  throw SimStop{"deep sleep"};
+}
+
+void esp_restart() { throw SimStop{"restart"}; }
+
+/*=================================== FREERTOS ===================================*/
+struct SimQueue {
+  UBaseType_t length;
+  UBaseType_t itemSize;
+  std::deque<std::vector<uint8_t>> items;
+};
+
+TaskHandle_t xTaskGetHandle(const char *) { return nullptr; }
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) { return 0; }
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) { return new SimQueue{length, itemSize, {}}; }
+
+BaseType_t xQueueSend(QueueHandle_t handle, const void *item, TickType_t) {
+  SimQueue *queue = (SimQueue *)handle;
+  if (queue->items.size() >= queue->length) return pdFALSE;
+  const uint8_t *bytes = (const uint8_t *)item;
+  queue->items.emplace_back(bytes, bytes + queue->itemSize);
+  return pdTRUE;
+}
+
+// Nothing else runs while the caller waits, so an empty queue stays empty
+BaseType_t xQueueReceive(QueueHandle_t handle, void *item, TickType_t) {
+  SimQueue *queue = (SimQueue *)handle;
+  if (queue->items.empty()) return pdFALSE;
+  memcpy(item, queue->items.front().data(), queue->itemSize);
+  queue->items.pop_front();
+  return pdTRUE;
+}
+
+/*=================================== FLASH ===================================*/
+// Same table as partitions.csv (only the partitions the firmware opens)
+esp_partition_t simPartitions[] = {
+  {ESP_PARTITION_TYPE_APP, 0x10, 0x10000, 0x140000, "app0"},
+  {ESP_PARTITION_TYPE_APP, 0x11, 0x150000, 0x140000, "app1"},
+  {ESP_PARTITION_TYPE_DATA, 0x40, 0x290000, 0x8000, "journal"},
+  {ESP_PARTITION_TYPE_DATA, 0x41, 0x298000, 0x80000, "patch"},
+};
+const uint8_t SIM_PARTITION_COUNT = sizeof(simPartitions) / sizeof(simPartitions[0]);
+std::vector<uint8_t> simFlash[SIM_PARTITION_COUNT];  // Allocated on first use
+int64_t simFlashBudget = -1;
+uint32_t simFlashReads = 0;
+uint32_t simFlashBytesWritten = 0;
+uint32_t simFlashSectorErases = 0;
+bool simFlashWriteFails = false;
+const esp_partition_t *simBootPartition = &simPartitions[0];
+
+// Counts one byte of erase or program work, cutting the power when the budget runs out
+void spendFlashBudget() {
+  if (simFlashBudget == 0) throw SimStop{"power cut"};
+  if (simFlashBudget > 0) simFlashBudget--;
+}
+
+std::vector<uint8_t> &partitionData(const esp_partition_t *partition) {
+  std::vector<uint8_t> &data = simFlash[partition - simPartitions];
+  if (data.empty()) data.assign(partition->size, 0xFF);
+  return data;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label) {
+  for (const esp_partition_t &partition : simPartitions) {
+    if (partition.type == type && partition.subtype == subtype && (label == nullptr || strcmp(partition.label, label) == 0)) return &partition;
+  }
+  return nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t offset, void *data, size_t size) {
+  if (offset + size > partition->size) return ESP_FAIL;
+  simFlashReads++;
+  memcpy(data, partitionData(partition).data() + offset, size);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t offset, const void *data, size_t size) {
+  if (offset + size > partition->size || simFlashWriteFails) return ESP_FAIL;
+  uint8_t *flash = partitionData(partition).data() + offset;
+  for (size_t i = 0; i < size; i++) {
+    spendFlashBudget();
+    flash[i] &= ((const uint8_t *)data)[i];  // NOR flash only clears bits
+    simFlashBytesWritten++;
+  }
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size) {
+  if (offset % 4096 != 0 || size % 4096 != 0 || offset + size > partition->size) return ESP_FAIL;
+  uint8_t *flash = partitionData(partition).data() + offset;
+  for (size_t i = 0; i < size; i++) {
+    spendFlashBudget();
+    flash[i] = 0xFF;
+  }
+  simFlashSectorErases += size / 4096;
+  return ESP_OK;
+}
+
+/*=================================== OTA ===================================*/
+size_t simOtaOffset = 0;
+
+const esp_partition_t *esp_ota_get_running_partition() { return &simPartitions[0]; }
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *) { return &simPartitions[1]; }
+
+esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t, esp_ota_handle_t *handle) {
+  simOtaOffset = 0;
+  *handle = 1;
+  return esp_partition_erase_range(partition, 0, partition->size);
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t, const void *data, size_t size) {
+  esp_err_t result = esp_partition_write(&simPartitions[1], simOtaOffset, data, size);
+  simOtaOffset += size;
+  return result;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t) { return ESP_OK; }
+esp_err_t esp_ota_abort(esp_ota_handle_t) { return ESP_OK; }
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition) {
+  simTrace("ota boot partition %s (%u bytes written)", partition->label, (unsigned)simOtaOffset);
+  simBootPartition = partition;
+  return ESP_OK;
+}
+
+/*=================================== CRC-32 ===================================*/
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *data, uint32_t length) {
+  crc = ~crc;
+  while (length--) {
+    crc ^= *data++;
+    for (uint8_t bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+  }
+  return ~crc;
+}
+
+/*=================================== SHA-256 ===================================*/
+const uint32_t SHA256_K[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be,
+  0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa,
+  0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85,
+  0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+  0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f,
+  0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static uint32_t rotateRight(uint32_t value, uint8_t bits) { return (value >> bits) | (value << (32 - bits)); }
+
+static void sha256Block(mbedtls_sha256_context *context, const uint8_t *block) {
+  uint32_t w[64];
+  for (uint8_t i = 0; i < 16; i++) w[i] = (uint32_t)block[i * 4] << 24 | block[i * 4 + 1] << 16 | block[i * 4 + 2] << 8 | block[i * 4 + 3];
+  for (uint8_t i = 16; i < 64; i++) {
+    uint32_t s0 = rotateRight(w[i - 15], 7) ^ rotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = rotateRight(w[i - 2], 17) ^ rotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+
+  uint32_t s[8];
+  memcpy(s, context->state, sizeof(s));
+  for (uint8_t i = 0; i < 64; i++) {
+    uint32_t t1 = s[7] + (rotateRight(s[4], 6) ^ rotateRight(s[4], 11) ^ rotateRight(s[4], 25)) + ((s[4] & s[5]) ^ (~s[4] & s[6])) + SHA256_K[i] + w[i];
+    uint32_t t2 = (rotateRight(s[0], 2) ^ rotateRight(s[0], 13) ^ rotateRight(s[0], 22)) + ((s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]));
+    memmove(s + 1, s, 7 * sizeof(uint32_t));
+    s[4] += t1;
+    s[0] = t1 + t2;
+  }
+  for (uint8_t i = 0; i < 8; i++) context->state[i] += s[i];
+}
+
+void mbedtls_sha256_init(mbedtls_sha256_context *context) { memset(context, 0, sizeof(*context)); }
+void mbedtls_sha256_free(mbedtls_sha256_context *context) { memset(context, 0, sizeof(*context)); }
+
+int mbedtls_sha256_starts(mbedtls_sha256_context *context, int is224) {
+  if (is224) return -1;
+  const uint32_t initial[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+  memcpy(context->state, initial, sizeof(initial));
+  context->length = 0;
+  return 0;
+}
+
+int mbedtls_sha256_update(mbedtls_sha256_context *context, const unsigned char *input, size_t length) {
+  while (length > 0) {
+    size_t used = context->length % 64;
+    size_t take = min(length, 64 - used);
+    memcpy(context->buffer + used, input, take);
+    context->length += take;
+    input += take;
+    length -= take;
+    if (used + take == 64) sha256Block(context, context->buffer);
+  }
+  return 0;
+}
+
+int mbedtls_sha256_finish(mbedtls_sha256_context *context, unsigned char output[32]) {
+  uint64_t bits = context->length * 8;
+  uint8_t padding[72] = {0x80};
+  size_t padLength = (context->length % 64 < 56 ? 56 : 120) - context->length % 64;
+  for (uint8_t i = 0; i < 8; i++) padding[padLength + i] = bits >> (56 - i * 8);
+  mbedtls_sha256_update(context, padding, padLength + 8);
+  for (uint8_t i = 0; i < 32; i++) output[i] = context->state[i / 4] >> (24 - (i % 4) * 8);
+  return 0;
+}
@@ -0,0 +1,104 @@
+// ESP-NOW and Wi-Fi for the simulator
+
+#include <WiFi.h>
+#include <esp_now.h>
+
+#include "sim.h"
+
+WiFiClass WiFi;
+
+bool simWifiAccessPoint = false;
+uint64_t simWifiJoinUs = 300000;
+
+wl_status_t WiFiClass::begin(const char *, const char *, int32_t, const uint8_t *, bool) {
+  joining = true;
+  joinStartUs = simNowUs();
+  return WL_DISCONNECTED;
+}
+
+wl_status_t WiFiClass::status() {
+  if (!joining || wifiMode == WIFI_OFF || !simWifiAccessPoint) return WL_DISCONNECTED;
+  return simNowUs() - joinStartUs >= simWifiJoinUs ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+bool WiFiClass::disconnect(bool, bool) {
+  joining = false;
+  return true;
+}
+
+bool simEspNowReady = false;
+esp_now_recv_cb_t simEspNowReceiveCallback = nullptr;
+esp_now_send_cb_t simEspNowSendCallback = nullptr;
+
+const uint8_t SIM_PEER_MAC[ESP_NOW_ETH_ALEN] = {0xCC, 0xDB, 0xA7, 0x2E, 0x0E, 0x14};  // Receiver address in src/ESPNOW.cpp
+const uint8_t SIM_REMOTE_MAC[ESP_NOW_ETH_ALEN] = {0x24, 0x6F, 0x28, 0x01, 0x02, 0x03};
+
+SimEspNowPeer simEspNowPeer = nullptr;
+bool simEspNowInPeer = false;  // The peer is handling a packet: its sends go to the remote
+
+std::string hexString(const uint8_t *data, size_t length) {
+  std::string text;
+  char digits[3];
+  for (size_t i = 0; i < length; i++) {
+    snprintf(digits, sizeof(digits), "%02x", data[i]);
+    text += digits;
+  }
+  return text;
+}
+
+esp_err_t esp_now_init() {
+  if (WiFi.getMode() == WIFI_OFF) return ESP_FAIL;
+  simEspNowReady = true;
+  return ESP_OK;
+}
+
+esp_err_t esp_now_deinit() {
+  simEspNowReady = false;
+  simEspNowReceiveCallback = nullptr;
+  simEspNowSendCallback = nullptr;
+  return ESP_OK;
+}
+
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t callback) {
+  simEspNowReceiveCallback = callback;
+  return ESP_OK;
+}
+
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t callback) {
+  simEspNowSendCallback = callback;
+  return ESP_OK;
+}
+
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t *) { return ESP_OK; }
+bool esp_now_is_peer_exist(const uint8_t *) { return true; }
+
+// Every packet is delivered: the send callback reports success right away
+esp_err_t esp_now_send(const uint8_t *mac, const uint8_t *data, size_t length) {
+  if (simEspNowInPeer) {  // The peer has its own radio, only packets for the remote are heard
+    if (length > ESP_NOW_MAX_DATA_LEN) return ESP_FAIL;
+    if (memcmp(mac, SIM_REMOTE_MAC, ESP_NOW_ETH_ALEN) == 0) simEspNowReceive(data, length);
+    return ESP_OK;
+  }
+
+  if (!simEspNowReady || length > ESP_NOW_MAX_DATA_LEN) return ESP_FAIL;
+  simRecord(SIM_ESPNOW, hexString(data, length));
+  if (simEspNowSendCallback != nullptr) simEspNowSendCallback(mac, ESP_NOW_SEND_SUCCESS);
+  if (simEspNowPeer != nullptr && memcmp(mac, SIM_PEER_MAC, ESP_NOW_ETH_ALEN) == 0) simEspNowPeerReceive(SIM_REMOTE_MAC, data, length);
+  return ESP_OK;
+}
+
+void simEspNowPeerReceive(const uint8_t *mac, const uint8_t *data, int length) {
+  if (simEspNowPeer == nullptr) return;
+  simEspNowInPeer = true;
+  simEspNowPeer(mac, data, length);
+  simEspNowInPeer = false;
+}
+
+void simEspNowReceive(const uint8_t *data, int length) {
+  if (!simEspNowReady || simEspNowReceiveCallback == nullptr) {
+    simTrace("espnow < %s dropped, radio off", hexString(data, length).c_str());
+    return;
+  }
+  simTrace("espnow < %s", hexString(data, length).c_str());
+  simEspNowReceiveCallback(SIM_PEER_MAC, data, length);
+}
@@ -0,0 +1,14 @@
+// Wall clock for the scheduler and the Wi-Fi cache: a fixed date plus the virtual time.
+// Defined here instead of in sim_platform.cpp because it replaces the C library's time().
+
+#include <time.h>
+
+#include "sim.h"
+
+const time_t SIM_EPOCH = 1767225600;  // 2026-01-01 00:00:00 UTC
+
+extern "C" time_t time(time_t *result) noexcept {
+  time_t now = SIM_EPOCH + (time_t)(simNowUs() / 1000000);
+  if (result != nullptr) *result = now;
+  return now;
+}
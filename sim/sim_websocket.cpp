@@ -0,0 +1,87 @@
+// Stand-in WebSocket server for the simulator: speaks the binary protocol of src/websocket_client.h,
+// answers every request after a fixed round trip and keeps the state of the four switches
+
+#include <WebSocketsClient.h>
+#include <WiFi.h>
+
+#include <deque>
+
+#include "sim.h"
+
+bool simWsServerUp = false;
+uint64_t simWsLatencyUs = 20000;
+bool simWsServerAnswers = true;
+std::vector<std::vector<uint8_t>> simWsRequests;
+uint8_t simWsSwitchState[4] = {};
+
+struct SimWsMessage {
+  uint64_t dueUs;
+  std::vector<uint8_t> data;
+};
+std::deque<SimWsMessage> simWsToClient;  // Responses and pushes on their way to the remote
+
+std::string hexString(const uint8_t *data, size_t length);  // sim_radio.cpp
+
+void simWsPush(const std::vector<uint8_t> &frame) { simWsToClient.push_back({simNowUs(), frame}); }
+
+// Server side of one request: [opcode][sequence][target][length][payload...]
+void simWsServe(const uint8_t *request, size_t length) {
+  simWsRequests.emplace_back(request, request + length);
+  if (!simWsServerAnswers || length < 4) return;
+
+  std::vector<uint8_t> response = {(uint8_t)(request[0] | 0x80), request[1], 0, 0};
+  if (request[0] == 0x01 && request[2] < 4 && length >= 5) {  // Switch set: answer with the switch state
+    simWsSwitchState[request[2]] = request[4];
+    response[3] = 2;
+    response.push_back(request[2]);
+    response.push_back(request[4]);
+  }
+  simWsToClient.push_back({simNowUs() + simWsLatencyUs, response});
+}
+
+void WebSocketsClient::begin(const char *, uint16_t, const char *, const char *) {
+  started = true;
+  handshakeDoneUs = 0;
+}
+
+void WebSocketsClient::loop() {
+  if (!started) return;
+  bool reachable = simWsServerUp && WiFi.status() == WL_CONNECTED;
+
+  if (connected && !reachable) {
+    connected = false;
+    simWsToClient.clear();
+    if (event != nullptr) event(WStype_DISCONNECTED, nullptr, 0);
+  }
+  if (!connected && reachable) {
+    if (handshakeDoneUs == 0) handshakeDoneUs = simNowUs() + simWsLatencyUs;
+    if (simNowUs() < handshakeDoneUs) return;
+    connected = true;
+    handshakeDoneUs = 0;
+    simTrace("websocket connected");
+    if (event != nullptr) event(WStype_CONNECTED, nullptr, 0);
+  }
+
+  while (connected && !simWsToClient.empty() && simWsToClient.front().dueUs <= simNowUs()) {
+    std::vector<uint8_t> message = simWsToClient.front().data;
+    simWsToClient.pop_front();
+    simTrace("websocket < %s", hexString(message.data(), message.size()).c_str());
+    if (event != nullptr) event(WStype_BIN, message.data(), message.size());
+  }
+}
+
+bool WebSocketsClient::sendBIN(const uint8_t *payload, size_t length) {
+  if (!connected) return false;
+  simTrace("websocket > %s", hexString(payload, length).c_str());
+  simWsServe(payload, length);
+  return true;
+}
+
+void WebSocketsClient::disconnect() {
+  started = false;
+  handshakeDoneUs = 0;
+  simWsToClient.clear();
+  if (!connected) return;
+  connected = false;
+  if (event != nullptr) event(WStype_DISCONNECTED, nullptr, 0);
+}
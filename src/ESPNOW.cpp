@@ -1,28 +1,67 @@
 #include "ESPNOW.h"
 
+#include <atomic>
+
+#include "delta_ota.h"
+
+#include "espnow_message.h"
+#include "settings.h"
+#include "wifi_client.h"
+
 #define STATUS_INDICATOR 2
 #define SELECT_BUTTON 32
 
 // REPLACE WITH YOUR RECEIVER MAC Address
 uint8_t broadcastAddress[] = {0xCC, 0xDB, 0xA7, 0x2E, 0x0E, 0x14};
 
-// Structure to send data
-typedef struct struct_message {
-  bool toggleSwitch[4];  // Control 4 LEDs
-} struct_message;
+// Kept in RTC memory so the last known switch state survives deep sleep.
+// Only the loop task reads or writes it; pushes from the receiver arrive through pushMailbox.
+RTC_DATA_ATTR struct_message switchData;
+
+// Lock-free mailbox between OnDataRecv (Wi-Fi task) and loop(): the packed switch bits of the
+// latest push plus MAILBOX_FULL. A newer push simply overwrites an unread one.
+const uint8_t MAILBOX_FULL = 0x80;
+std::atomic<uint8_t> pushMailbox(0);
 
-struct_message switchData;
+bool switchStateChanged = false;  // Set when switchData changes, cleared by espNowPoll()
+
+// A switch state on its way to the receiver. OnDataSent (Wi-Fi task) reports it through switchSendDone.
+const unsigned long SWITCH_SEND_TIMEOUT = 50;  // ms, the send callback normally comes within a few ms
+bool switchSendActive = false;
+unsigned long switchSendStart = 0;
+std::atomic<bool> switchSendDone(false);
+
+// Menu labels with the live switch state (used as titles of the Home Automation menu)
+char switchLabel[4][16] = {"Switch 1", "Switch 2", "Switch 3", "Switch 4"};
 
 esp_now_peer_info_t peerInfo;
 
+bool espNowActive = false;      // ESP-NOW initialized
+bool espNowSubscribed = false;  // Keep ESP-NOW listening between commands
+
 // Callback function when data is received
 void OnDataRecv(const uint8_t *mac, const uint8_t *incomingData, int len) {
-  // Copy the data into the struct message
-  memcpy(&switchData, incomingData, sizeof(switchData));
+  if (isDeltaOtaMessage(incomingData, len)) {
+    deltaOtaReceive(mac, incomingData, len);
+    return;
+  }
+
+  // Only state pushes from the receiver carry the switch state
+  if (len != sizeof(struct_message) || incomingData[0] != MSG_STATE_PUSH) return;
+
+  struct_message message;
+  memcpy(&message, incomingData, sizeof(message));
+
+  uint8_t bits = MAILBOX_FULL;
+  for (int i = 0; i < 4; i++) {
+    if (message.toggleSwitch[i]) bits |= 1 << i;
+  }
+  pushMailbox.store(bits, std::memory_order_release);
 }
 
 // Callback function when data is sent
 void OnDataSent(const uint8_t *mac_addr, esp_now_send_status_t status) {
+  switchSendDone.store(true, std::memory_order_release);
   Serial.print("\r\nLast Packet Send Status:\t");
   Serial.println(status == ESP_NOW_SEND_SUCCESS ? "Delivery Success" : "Delivery Fail");
 }
@@ -38,6 +77,8 @@ void printWiFiState() {
 }
 
 void initESPNow() {
+  if (espNowActive) return;
+
   // Set device as a Wi-Fi Station
   WiFi.mode(WIFI_STA);
   printWiFiState();
@@ -47,6 +88,7 @@ void initESPNow() {
     Serial.println("Error initializing ESP-NOW");
     return;
   }
+  espNowActive = true;
 
   esp_now_register_recv_cb(OnDataRecv);  // Register data received callback
   esp_now_register_send_cb(OnDataSent);  // Register data send callback
@@ -65,22 +107,103 @@ void initESPNow() {
 
 // Disable Wifi/ESPNOW to save power
 void deInitESPNow() {
+  if (!espNowActive) return;
+
   if (esp_now_deinit() == ESP_OK) {
+    espNowActive = false;
     Serial.println("ESP-NOW de-initialized");
-    WiFi.mode(WIFI_OFF);
+    if (!wifiActive()) WiFi.mode(WIFI_OFF);  // Keep the radio on while the Wi-Fi client uses it
     printWiFiState();
   } else {
     Serial.println("Error de-initializing ESP-NOW");
   }
 }
 
+// Ask the receiver for its state (it also registers us for unprompted pushes)
+void requestSwitchState() {
+  struct_message request = {MSG_STATE_REQUEST, {}};
+  esp_now_send(broadcastAddress, (uint8_t *)&request, sizeof(request));
+}
+
+void updateSwitchLabels() {
+  for (int i = 0; i < 4; i++) {
+    snprintf(switchLabel[i], sizeof(switchLabel[i]), "Switch %d: %s", i + 1, switchData.toggleSwitch[i] ? "ON" : "OFF");
+  }
+}
+
+// Apply the latest push from the receiver. Returns true if any switch state changed since the last call.
+bool espNowPoll() {
+  switchSendPoll();
+  uint8_t bits = pushMailbox.exchange(0, std::memory_order_acquire);
+
+  if (bits & MAILBOX_FULL) {
+    bool changed = false;
+    for (int i = 0; i < 4; i++) changed |= restoreSwitchState(i, (bits >> i) & 1);
+    if (changed) markSettingsDirty();  // Also right after loadSettings(), which leaves switchStateChanged set
+  }
+
+  if (!switchStateChanged) return false;
+  switchStateChanged = false;
+  updateSwitchLabels();
+  return true;
+}
+
 void dataUpdateOnStartup() {
   initESPNow();
   Serial.println("Pull switch state data from receiver");
-  delay(500);
+  requestSwitchState();
+  delay(500);  // The receiver answers with MSG_STATE_PUSH
+  if (!espNowSubscribed) deInitESPNow();
+  espNowPoll();
+}
+
+// Keep ESP-NOW listening so pushed updates from the receiver are applied live
+void espNowSubscribe() {
+  if (espNowSubscribed) return;
+  initESPNow();
+  espNowSubscribed = true;
+  updateSwitchLabels();  // Show the last known state until the receiver answers
+  requestSwitchState();
+}
+
+bool espNowListening() {
+  return espNowSubscribed && espNowActive;
+}
+
+void espNowUnsubscribe() {
+  if (!espNowSubscribed) return;
+  espNowSubscribed = false;
   deInitESPNow();
 }
 
+// Send the whole switch state to the receiver
+void transmitSwitchData() {
+  markSettingsDirty();
+  switchStateChanged = true;
+  switchData.type = MSG_SWITCH_SET;
+
+  // Send message via ESP-NOW; switchSendPoll() turns the radio off once it is out
+  switchSendDone.store(false, std::memory_order_relaxed);
+  esp_err_t result = esp_now_send(broadcastAddress, (uint8_t *)&switchData, sizeof(switchData));
+
+  if (result == ESP_OK) {
+    Serial.println("Sent with success");
+    switchSendActive = true;
+    switchSendStart = millis();
+  } else {
+    Serial.println("Error sending the data");
+  }
+}
+
+bool switchSendPoll() {
+  if (!switchSendActive) return false;
+  if (!switchSendDone.load(std::memory_order_acquire) && millis() - switchSendStart < SWITCH_SEND_TIMEOUT) return true;
+
+  switchSendActive = false;
+  if (!espNowSubscribed) deInitESPNow();  // Turn off WiFi after sending the data
+  return false;
+}
+
 // Send data
 void sendSwitchData(int switchIndex) {
   int buttonState = digitalRead(SELECT_BUTTON);
@@ -88,18 +211,29 @@ void sendSwitchData(int switchIndex) {
   if (buttonState == LOW) {
     // Toggle the corresponding switch state
     switchData.toggleSwitch[switchIndex] = !switchData.toggleSwitch[switchIndex];
+    transmitSwitchData();
+  }
+}
 
-    // Send message via ESP-NOW
-    esp_err_t result = esp_now_send(broadcastAddress, (uint8_t *)&switchData, sizeof(switchData));
+// Set a switch to an explicit state without user input (used by scheduled jobs)
+void setSwitchState(int switchIndex, bool state) {
+  if (switchIndex < 0 || switchIndex > 3) return;
 
-    if (result == ESP_OK) {
-      Serial.println("Sent with success");
-      deInitESPNow();  // Turn off WiFi after successfully sending the data
-    } else {
-      Serial.println("Error sending the data");
-    }
-    delay(50);
-  }
+  initESPNow();
+  switchData.toggleSwitch[switchIndex] = state;
+  transmitSwitchData();
+}
+
+bool getSwitchState(int switchIndex) {
+  return switchData.toggleSwitch[switchIndex];
+}
+
+// Restore a saved switch state locally without sending it. Returns true if the state changed.
+bool restoreSwitchState(int switchIndex, bool state) {
+  if (switchData.toggleSwitch[switchIndex] == state) return false;
+  switchData.toggleSwitch[switchIndex] = state;
+  switchStateChanged = true;
+  return true;
 }
 
 void sendDataSwitch1() {
@@ -4,10 +4,22 @@
 #include <esp_now.h>
 #include <WiFi.h>
 
+// Home Automation menu labels ("Switch 1: ON"), kept up to date with the switch state
+extern char switchLabel[4][16];
+
 void dataUpdateOnStartup();
+bool espNowPoll();  // Put this in the void loop in the main.cpp. Returns true when a switch state changed
+void espNowSubscribe();    // Keep listening for pushed updates (while the Home Automation menu is open)
+void espNowUnsubscribe();
+bool espNowListening();
 void sendDataSwitch1();
 void sendDataSwitch2();
 void sendDataSwitch3();
 void sendDataSwitch4();
+void setSwitchState(int switchIndex, bool state);  // Returns once the send started, see switchSendPoll()
+bool switchSendPoll();  // Completes the last switch send once it is out. Returns true while it is on its way.
+bool getSwitchState(int switchIndex);
+bool restoreSwitchState(int switchIndex, bool state);  // Returns true if the state changed
+void updateSwitchLabels();  // Rebuild switchLabel from the switch state (espNowPoll() does it on every change)
 
 #endif
\ No newline at end of file
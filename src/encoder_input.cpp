@@ -0,0 +1,90 @@
+#include "encoder_input.h"
+
+#include <stdlib.h>
+
+// REPLACE WITH YOUR PREFERRED ACCELERATION
+EncoderCurve encoderCurves[ENCODER_CONTEXT_COUNT] = {
+  {8, 40, 4},   // ENCODER_MENU: up to 4 items per count when flicking through long lists
+  {6, 30, 3},   // ENCODER_TEMPERATURE: 16 to 30 °C in a few counts
+  {20, 60, 2},  // ENCODER_INDEX: short ranges, mild acceleration only
+};
+
+const unsigned long ENCODER_VELOCITY_WINDOW = 120000;  // Duration (us) of turning used for the speed estimate
+const uint8_t ENCODER_EDGE_COUNT = 8;                  // Count changes kept for the estimate
+const int ENCODER_STEP_ONE = 16;                       // Pending steps are kept in 1/16 to keep fractional gains
+
+struct EncoderEdge {
+  unsigned long timeUs;
+  int counts;
+};
+
+EncoderEdge encoderEdges[ENCODER_EDGE_COUNT];
+uint8_t encoderEdgeNext = 0;
+int encoderLastCount = 0;
+uint16_t encoderSpeed = 0;
+int encoderPending[ENCODER_CONTEXT_COUNT];  // In 1/ENCODER_STEP_ONE steps
+
+// Counts per second over the edges inside the window. The counts of the oldest edge were made
+// before its timestamp, so they are left out of the rate.
+uint16_t estimateVelocity(unsigned long nowUs) {
+  unsigned long total = 0;
+  unsigned long oldestAge = 0;
+  unsigned long oldestCounts = 0;
+  for (const EncoderEdge &edge : encoderEdges) {
+    unsigned long age = nowUs - edge.timeUs;
+    if (edge.counts == 0 || age > ENCODER_VELOCITY_WINDOW) continue;
+    total += abs(edge.counts);
+    if (age >= oldestAge) {
+      oldestAge = age;
+      oldestCounts = abs(edge.counts);
+    }
+  }
+
+  if (oldestAge == 0) return 0;  // First edge after a pause: no interval yet, start without acceleration
+  unsigned long speed = (total - oldestCounts) * 1000000UL / oldestAge;
+  return speed > 65535 ? 65535 : speed;
+}
+
+// Gain in 1/ENCODER_STEP_ONE
+int curveGain(const EncoderCurve &curve, uint16_t speed) {
+  if (speed <= curve.slowSpeed || curve.maxGain <= 1) return ENCODER_STEP_ONE;
+  if (speed >= curve.fastSpeed) return curve.maxGain * ENCODER_STEP_ONE;
+  return ENCODER_STEP_ONE + (curve.maxGain - 1) * ENCODER_STEP_ONE * (speed - curve.slowSpeed) / (curve.fastSpeed - curve.slowSpeed);
+}
+
+bool encoderInputUpdate(int count, unsigned long nowUs) {
+  int counts = count - encoderLastCount;
+  encoderLastCount = count;
+  if (counts == 0) return false;
+
+  // Turning back starts a new estimate: the speed in the old direction says nothing about the new one
+  const EncoderEdge &previous = encoderEdges[(encoderEdgeNext + ENCODER_EDGE_COUNT - 1) % ENCODER_EDGE_COUNT];
+  if ((previous.counts > 0) != (counts > 0)) {
+    for (EncoderEdge &edge : encoderEdges) edge.counts = 0;
+  }
+
+  encoderEdges[encoderEdgeNext] = {nowUs, counts};
+  encoderEdgeNext = (encoderEdgeNext + 1) % ENCODER_EDGE_COUNT;
+  encoderSpeed = estimateVelocity(nowUs);
+
+  for (uint8_t context = 0; context < ENCODER_CONTEXT_COUNT; context++) {
+    encoderPending[context] += counts * curveGain(encoderCurves[context], encoderSpeed);
+  }
+  return true;
+}
+
+int encoderTakeSteps(EncoderContext context) {
+  int steps = encoderPending[context] / ENCODER_STEP_ONE;  // Rounds toward zero, the fraction stays pending
+  int remainder = encoderPending[context] - steps * ENCODER_STEP_ONE;
+  encoderInputClear();
+  encoderPending[context] = remainder;
+  return steps;
+}
+
+void encoderInputClear() {
+  for (int &pending : encoderPending) pending = 0;
+}
+
+uint16_t encoderVelocity() {
+  return encoderSpeed;
+}
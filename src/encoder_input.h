@@ -0,0 +1,34 @@
+#ifndef ENCODER_INPUT_H
+#define ENCODER_INPUT_H
+
+#include <stdint.h>
+
+// Rotary encoder input with acceleration.
+// encoderInputUpdate() timestamps every change of the encoder count and estimates the turning
+// speed over the last ENCODER_VELOCITY_WINDOW. Each change is scaled by the acceleration curve
+// of every context and added to that context's pending steps. A consumer takes all the steps
+// collected since it last ran with encoderTakeSteps() (several per frame when the knob is turned
+// fast), which also clears the other contexts so the same turn is never applied twice.
+
+enum EncoderContext {
+  ENCODER_MENU,         // Menu list scrolling
+  ENCODER_TEMPERATURE,  // A/C temperature
+  ENCODER_INDEX,        // A/C fan and mode index
+  ENCODER_CONTEXT_COUNT
+};
+
+// Gain is 1 up to slowSpeed, rises linearly to maxGain at fastSpeed and stays there (speeds in counts per second)
+struct EncoderCurve {
+  uint16_t slowSpeed;
+  uint16_t fastSpeed;
+  uint8_t maxGain;
+};
+
+extern EncoderCurve encoderCurves[ENCODER_CONTEXT_COUNT];
+
+bool encoderInputUpdate(int count, unsigned long nowUs);  // Call once per loop with the encoder count; true when it changed
+int encoderTakeSteps(EncoderContext context);             // Signed steps since the last call, cleared afterwards
+void encoderInputClear();                                 // Drop pending steps, e.g. when the screen changes
+uint16_t encoderVelocity();                               // Latest speed estimate (counts per second)
+
+#endif
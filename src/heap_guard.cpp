@@ -0,0 +1,95 @@
+#include "heap_guard.h"
+
+#include <Arduino.h>
+
+#ifdef HEAP_GUARD
+
+struct HeapRecord {
+  uint32_t caller;  // Code address that called malloc/calloc/realloc
+  uint32_t size;
+  uint32_t time;  // millis()
+};
+
+const uint8_t HEAP_RECORD_COUNT = 16;  // Latest allocations kept until heapGuardLoop() prints them
+
+HeapRecord heapRecords[HEAP_RECORD_COUNT];
+volatile uint32_t heapRecordTotal = 0;  // Allocations since armHeapGuard()
+uint32_t heapRecordsReported = 0;
+volatile bool heapGuardArmed = false;
+portMUX_TYPE heapGuardLock = portMUX_INITIALIZER_UNLOCKED;
+
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *pointer, size_t size);
+
+// The two top bits of an Xtensa return address hold the register window size, not the address
+static uint32_t callerAddress(void *returnAddress) {
+  return ((uint32_t)(uintptr_t)returnAddress & 0x3FFFFFFF) | 0x40000000;
+}
+
+// Called from any task or interrupt: no printing, no allocation, only a short critical section
+static void recordAllocation(void *returnAddress, size_t size) {
+  if (!heapGuardArmed) return;
+
+  portENTER_CRITICAL_SAFE(&heapGuardLock);
+  HeapRecord &record = heapRecords[heapRecordTotal % HEAP_RECORD_COUNT];
+  record.caller = callerAddress(returnAddress);
+  record.size = size;
+  record.time = millis();
+  heapRecordTotal++;
+  portEXIT_CRITICAL_SAFE(&heapGuardLock);
+}
+
+void *__wrap_malloc(size_t size) {
+  recordAllocation(__builtin_return_address(0), size);
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+  recordAllocation(__builtin_return_address(0), count * size);
+  return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *pointer, size_t size) {
+  recordAllocation(__builtin_return_address(0), size);
+  return __real_realloc(pointer, size);
+}
+}
+
+void armHeapGuard() {
+  heapGuardArmed = true;
+  Serial.println("Heap guard armed");
+}
+
+void heapGuardLoop() {
+  while (heapRecordsReported < heapRecordTotal) {
+    portENTER_CRITICAL(&heapGuardLock);
+    uint32_t total = heapRecordTotal;
+    uint32_t skipped = 0;
+    if (total - heapRecordsReported > HEAP_RECORD_COUNT) {  // Older records were overwritten
+      skipped = total - HEAP_RECORD_COUNT - heapRecordsReported;
+      heapRecordsReported = total - HEAP_RECORD_COUNT;
+    }
+    HeapRecord record = heapRecords[heapRecordsReported % HEAP_RECORD_COUNT];
+    portEXIT_CRITICAL(&heapGuardLock);
+
+    // Short lines: Serial.printf falls back to malloc above 64 characters
+    if (skipped > 0) Serial.printf("HEAP %lu allocations not recorded\n", (unsigned long)skipped);
+    Serial.printf("HEAP alloc %lu bytes from 0x%08lx at %lu ms\n", (unsigned long)record.size, (unsigned long)record.caller,
+                  (unsigned long)record.time);
+    heapRecordsReported++;
+  }
+}
+
+uint32_t heapAllocationsAfterSetup() {
+  return heapRecordTotal;
+}
+
+#else
+
+void armHeapGuard() {}
+void heapGuardLoop() {}
+uint32_t heapAllocationsAfterSetup() { return 0; }
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef HEAP_GUARD_H
+#define HEAP_GUARD_H
+
+#include <stdint.h>
+
+// Heap allocation tracking for the zero-heap steady state (pio run -e heap_guard)
+// After setup() the remote should run without heap allocations: buffers are static or sized at
+// boot. In the heap_guard build malloc/calloc/realloc are wrapped at link time (-Wl,--wrap) and
+// every allocation after armHeapGuard() is counted and recorded with its caller address
+// (xtensa-esp32-elf-addr2line -e .pio/build/heap_guard/firmware.elf <address>).
+// Records are printed by heapGuardLoop() from the loop task, never from inside malloc.
+// In the normal build these functions do nothing.
+
+void armHeapGuard();   // Put this at the end of the void setup in the main.cpp
+void heapGuardLoop();  // Put this in the void loop in the main.cpp
+uint32_t heapAllocationsAfterSetup();
+
+#endif
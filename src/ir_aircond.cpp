@@ -4,16 +4,25 @@
 #include <ir_Daikin.h>
 #include <ir_Sharp.h>
 
-// Instances for sending IR signals
+#include "encoder_input.h"
+#include "ir_emitter.h"
+#include "render_cache.h"
+#include "settings.h"
+
+// Instances building the A/C states. The frames are sent by the RMT emitters,
+// begin() is never called because it would take the pin back from the RMT.
 IRSharpAc sharpAc(IR_LED);
 IRDaikin64 daikinAc(IR_LED);
 
 // Function to initialize the IR sender
 void initIrAirCond() {
-  sharpAc.begin();
-  daikinAc.begin();
+  initIrEmitters();
 }
 
+IrCommand sharpAcCommand() { return irStateCommand(IR_PROTOCOL_SHARP_AC, sharpAc.getRaw(), kSharpAcStateLength); }
+void sendSharpAc() { irEmit(IR_SHARP_AC, sharpAcCommand()); }
+void sendDaikinAc() { irEmit(IR_DAIKIN_AC, irCodeCommand(IR_PROTOCOL_DAIKIN64, daikinAc.getRaw(), kDaikin64Bits)); }
+
 /* ------------------- General variables and functions for AC control ------------------ */
 bool irSignalSent = true;  // Tracks wether IR signal has been sent
 unsigned long lastInputTime = 0;  // Records timestamp of last encoder input
@@ -23,23 +32,25 @@ const unsigned long inactivityDuration = 2000;  // Duration (ms) before sending
 void resetTimer() {
   lastInputTime = millis();
   irSignalSent = false;
+  markSettingsDirty();
 }
 
-// Adjusts encoder-controlled value within specified range
-void inputEncoder(uint8_t& value, int min, int max) {
-  if (encoderCurrentRead > encoderLastRead && value < max) {
-    value++;  // Increment value if within max limit
+// Adjusts encoder-controlled value within specified range by the steps turned since the last frame
+void inputEncoder(uint8_t& value, int min, int max, EncoderContext context) {
+  int steps = encoderTakeSteps(context);
+  if (steps > 0 && value < max) {
+    value = value + steps < max ? value + steps : max;  // Increment value up to the max limit
     resetTimer();
   }
-  if (encoderLastRead > encoderCurrentRead && value > min) {
-    value--;  // Decrement value if within min limit
+  if (steps < 0 && value > min) {
+    value = value + steps > min ? value + steps : min;  // Decrement value down to the min limit
     resetTimer();
   }
 }
 
-// Toggles a boolean state using the encoder input
+// Toggles a boolean state using the encoder input (once per frame)
 void toggleEncoder(bool& state) {
-  if (encoderCurrentRead > encoderLastRead || encoderLastRead > encoderCurrentRead) {
+  if (encoderTakeSteps(ENCODER_INDEX) != 0) {
     state = !state;  // Toggle the state
     resetTimer();
   }
@@ -82,17 +93,17 @@ void sharpAcUI() {
 
   u8g2.setFont(u8g2_font_profont29_tr);
   // sharpSetModeIndex: 0 = Auto, 1 = Dry
-  u8g2.drawStr(2, 41, sharpSetModeIndex == 0 || sharpSetModeIndex == 1 ? "--" : tempStr);
+  cachedDrawStr(2, 41, sharpSetModeIndex == 0 || sharpSetModeIndex == 1 ? "--" : tempStr);
   u8g2.drawXBMP(36, 22, 16, 16, celcius_bits);
   u8g2.setFont(u8g2_font_profont11_tr);
-  u8g2.drawStr(63, 14, "Mode:");
-  u8g2.drawStr(97, 14, sharpSetModeLabel[sharpSetModeIndex]);
+  cachedDrawStr(63, 14, "Mode:");
+  cachedDrawStr(97, 14, sharpSetModeLabel[sharpSetModeIndex]);
   u8g2.drawRFrame(56, 0, 72, 22, 4);
-  u8g2.drawStr(63, 35, "Fan:");
-  u8g2.drawStr(95, 35, sharpSetFanLabel[sharpSetFanIndex]);
+  cachedDrawStr(63, 35, "Fan:");
+  cachedDrawStr(95, 35, sharpSetFanLabel[sharpSetFanIndex]);
   u8g2.drawRFrame(56, 21, 72, 22, 4);
-  u8g2.drawStr(63, 57, "Swing:");
-  u8g2.drawStr(103, 57, sharpGetSwingString(sharpSetSwing));
+  cachedDrawStr(63, 57, "Swing:");
+  cachedDrawStr(103, 57, sharpGetSwingString(sharpSetSwing));
   u8g2.drawRFrame(56, 42, 72, 22, 4);
   u8g2.setDrawColor(1);
 
@@ -117,21 +128,49 @@ void sharpAcPowerToggle() {
     sharpAc.on();
     currentPowerState = true;
   }
-  sharpAc.send();
+  sendSharpAc();
+  markSettingsDirty();
+}
+
+// Turns the AC off regardless of the tracked power state (used by scheduled jobs)
+void sharpAcPowerOff() {
+  sharpAcQueuePowerOff();
+  irFlush();
+}
+
+// Queues the off frame so it can go out together with other emitters (see irPowerOffAll)
+void sharpAcQueuePowerOff() {
+  sharpAc.off();
+  currentPowerState = false;
+  irQueue(IR_SHARP_AC, sharpAcCommand());
+  markSettingsDirty();
+}
+
+// Sends a complete state and turns the AC on (serial commands and scenes)
+void sharpAcApplyState(uint8_t temp, uint8_t modeIndex, uint8_t fanIndex, bool swing) {
+  sharpSetTemp = temp;
+  sharpSetModeIndex = modeIndex;
+  sharpSetFanIndex = fanIndex;
+  sharpSetSwing = swing;
+  sharpAcSetting();
+  sharpAc.on();
+  currentPowerState = true;
+  sendSharpAc();
+  markSettingsDirty();
 }
 
 // Automatically sends IR signal if there's no input for a set duration
 void sharpAcChkInactivity() {
   if (!irSignalSent && millis() - lastInputTime >= inactivityDuration) {
     sharpAcSetting();
-    sharpAc.send();
+    sendSharpAc();
     irSignalSent = true;
   }
 }
 
 // Set temperature within valid range (16-30°C). Only for cool mode
 void sharpAcSetTemp() {
-  if (sharpSetModeIndex == 2) inputEncoder(sharpSetTemp, 16, 30);  //  2 = cool
+  if (sharpSetModeIndex == 2) inputEncoder(sharpSetTemp, 16, 30, ENCODER_TEMPERATURE);  //  2 = cool
 }
 void sharpAcSetTempUI() {
   sharpAcSetTemp();
@@ -140,7 +179,7 @@ void sharpAcSetTempUI() {
 
 // Set fan speed based on current AC mode. Only for cool mode
 void sharpAcSetFan() {
-  if (sharpSetModeIndex == 2) inputEncoder(sharpSetFanIndex, 0, 3);  // 2 = cool
+  if (sharpSetModeIndex == 2) inputEncoder(sharpSetFanIndex, 0, 3, ENCODER_INDEX);  // 2 = cool
 }
 void sharpAcSetFanUI() {
   sharpAcSetFan();
@@ -149,7 +188,7 @@ void sharpAcSetFanUI() {
 
 // Set mode within valid range (index 0-2)
 void sharpAcSetMode() {
-  inputEncoder(sharpSetModeIndex, 0, 2);
+  inputEncoder(sharpSetModeIndex, 0, 2, ENCODER_INDEX);
   sharpValidateFanSetting();
 }
 void sharpAcSetModeUI() {
@@ -192,17 +231,17 @@ void daikinAcUI() {
   sprintf(tempStr, "%d", daikinSetTemp);  // Convert temperature to string
 
   u8g2.setFont(u8g2_font_profont29_tr);
-  u8g2.drawStr(2, 41, tempStr);
+  cachedDrawStr(2, 41, tempStr);
   u8g2.drawXBMP(36, 22, 16, 16, celcius_bits);
   u8g2.setFont(u8g2_font_profont11_tr);
-  u8g2.drawStr(63, 14, "Mode:");
-  u8g2.drawStr(97, 14, daikinSetModeLabel[daikinSetModeIndex]);
+  cachedDrawStr(63, 14, "Mode:");
+  cachedDrawStr(97, 14, daikinSetModeLabel[daikinSetModeIndex]);
   u8g2.drawRFrame(56, 0, 72, 22, 4);
-  u8g2.drawStr(63, 35, "Fan:");
-  u8g2.drawStr(95, 35, daikinSetFanLabel[daikinSetFanIndex]);
+  cachedDrawStr(63, 35, "Fan:");
+  cachedDrawStr(95, 35, daikinSetFanLabel[daikinSetFanIndex]);
   u8g2.drawRFrame(56, 21, 72, 22, 4);
-  u8g2.drawStr(63, 57, "Swing:");
-  u8g2.drawStr(103, 57, daikinGetSwingString(daikinSetSwing));
+  cachedDrawStr(63, 57, "Swing:");
+  cachedDrawStr(103, 57, daikinGetSwingString(daikinSetSwing));
   u8g2.drawRFrame(56, 42, 72, 22, 4);
   u8g2.setDrawColor(1);
 
@@ -221,7 +260,19 @@ void daikinAcSetting() {
 void daikinAcPowerToggle() {
   daikinAcSetting();
   daikinAc.setPowerToggle(true);
-  daikinAc.send();
+  sendDaikinAc();
+}
+
+// Sends a complete state, optionally toggling the power (serial commands and scenes)
+void daikinAcApplyState(uint8_t temp, uint8_t modeIndex, uint8_t fanIndex, bool swing, bool powerToggle) {
+  daikinSetTemp = temp;
+  daikinSetModeIndex = modeIndex;
+  daikinSetFanIndex = fanIndex;
+  daikinSetSwing = swing;
+  daikinAcSetting();
+  daikinAc.setPowerToggle(powerToggle);
+  sendDaikinAc();
+  markSettingsDirty();
 }
 
 // Automatically sends IR signal if there's no input for a set duration
@@ -229,13 +280,13 @@ void daikinAcChkInactivity() {
   if (!irSignalSent && millis() - lastInputTime >= inactivityDuration) {
     daikinAcSetting();
     daikinAc.setPowerToggle(false);
-    daikinAc.send();
+    sendDaikinAc();
     irSignalSent = true;
   }
 }
 
 // Set temperature within valid range (16-30°C)
-void daikinAcSetTemp() { inputEncoder(daikinSetTemp, 16, 30); }
+void daikinAcSetTemp() { inputEncoder(daikinSetTemp, 16, 30, ENCODER_TEMPERATURE); }
 void daikinAcSetTempUI() {
   daikinAcSetTemp();
   daikinAcUI();
@@ -244,9 +295,9 @@ void daikinAcSetTempUI() {
 // Set fan speed based on current AC mode
 void daikinAcSetFan() {
   if (daikinSetModeIndex == 0)
-    inputEncoder(daikinSetFanIndex, 2, 4);  // Constrain the fan index to Min (2) to Max (4) in Fan mode
+    inputEncoder(daikinSetFanIndex, 2, 4, ENCODER_INDEX);  // Constrain the fan index to Min (2) to Max (4) in Fan mode
   else
-    inputEncoder(daikinSetFanIndex, 0, 5);  // In other modes, the full range of fan speeds (0-5) is allowed
+    inputEncoder(daikinSetFanIndex, 0, 5, ENCODER_INDEX);  // In other modes, the full range of fan speeds (0-5) is allowed
 }
 void daikinAcSetFanUI() {
   daikinAcSetFan();
@@ -255,7 +306,7 @@ void daikinAcSetFanUI() {
 
 // Set mode within valid range (index 0-2)
 void daikinAcSetMode() {
-  inputEncoder(daikinSetModeIndex, 0, 2);
+  inputEncoder(daikinSetModeIndex, 0, 2, ENCODER_INDEX);
   daikinValidateFanSetting();
 }
 void daikinAcSetModeUI() {
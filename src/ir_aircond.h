@@ -6,19 +6,38 @@
 
 extern const uint8_t IR_LED;
 extern U8G2_SH1106_128X64_NONAME_F_HW_I2C u8g2;
-extern int encoderCurrentRead;
-extern int encoderLastRead;
+
+// Current AC settings (persisted by the settings journal)
+extern bool currentPowerState;
+extern uint8_t sharpSetTemp;
+extern uint8_t sharpSetModeIndex;
+extern uint8_t sharpSetFanIndex;
+extern bool sharpSetSwing;
+extern uint8_t daikinSetTemp;
+extern uint8_t daikinSetModeIndex;
+extern uint8_t daikinSetFanIndex;
+extern bool daikinSetSwing;
+extern bool irSignalSent;  // False while a changed setting waits to be sent after the inactivity duration
+
+// Menu labels, also accepted by the serial commands
+extern const char* sharpSetModeLabel[3];
+extern const char* sharpSetFanLabel[4];
+extern const char* daikinSetModeLabel[3];
+extern const char* daikinSetFanLabel[6];
 
 // Initializes the IR sender
 void initIrAirCond();
 
 // Command to control Sharp air-conditioner
 void sharpAcPowerToggle();
+void sharpAcPowerOff();
+void sharpAcQueuePowerOff();
 void sharpAcSetTempUI();
 void sharpAcSetFanUI();
 void sharpAcSetModeUI();
 void sharpAcSetSwingUI();
 void sharpAcChkInactivity();
+void sharpAcApplyState(uint8_t temp, uint8_t modeIndex, uint8_t fanIndex, bool swing);  // Power on with a full state
 
 // Command to control Daikin air-conditioner
 void daikinAcPowerToggle();
@@ -27,5 +46,6 @@ void daikinAcSetModeUI();
 void daikinAcSetFanUI();
 void daikinAcSetSwingUI();
 void daikinAcChkInactivity();
+void daikinAcApplyState(uint8_t temp, uint8_t modeIndex, uint8_t fanIndex, bool swing, bool powerToggle);
 
 #endif
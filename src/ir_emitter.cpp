@@ -0,0 +1,377 @@
+#include "ir_emitter.h"
+
+#include <Arduino.h>
+#include <driver/rmt.h>
+
+#include "metrics.h"
+
+// REPLACE WITH YOUR EMITTER PINS. Emitter 0 is the original IR LED.
+const uint8_t IR_EMITTER_PINS[IR_EMITTER_COUNT] = {IR_LED, 16, 4};
+
+// REPLACE WITH YOUR WIRING: emitter index used for every appliance (see ir_emitter.h)
+// The three appliances "Power Off All" sends to are on different emitters so the burst runs in parallel.
+uint8_t irApplianceEmitter[IR_APPLIANCE_COUNT] = {
+  2,  // IR_DEKA_FAN
+  1,  // IR_FFT_FAN
+  0,  // IR_LG_TV
+  0,  // IR_ASTRO
+  0,  // IR_SHARP_AC
+  1,  // IR_DAIKIN_AC
+};
+
+/*=============================== PROTOCOL TIMINGS ===============================*/
+// Values (us) mirror IRremoteESP8266 so the output matches what the library used to send.
+
+// NEC
+const uint32_t NEC_HDR_MARK = 8960;
+const uint32_t NEC_HDR_SPACE = 4480;
+const uint32_t NEC_BIT_MARK = 560;
+const uint32_t NEC_ONE_SPACE = 1680;
+const uint32_t NEC_ZERO_SPACE = 560;
+const uint32_t NEC_RPT_SPACE = 2240;
+const uint32_t NEC_MIN_COMMAND_LENGTH = 108080;
+const uint32_t NEC_MIN_GAP = 22400;
+
+// RC6
+const uint32_t RC6_TICK = 444;
+const uint32_t RC6_HDR_MARK = 6 * RC6_TICK;
+const uint32_t RC6_HDR_SPACE = 2 * RC6_TICK;
+const uint32_t RC6_RPT_LENGTH = 187 * RC6_TICK;
+
+// Symphony
+const uint32_t SYMPHONY_ZERO_MARK = 400;
+const uint32_t SYMPHONY_ZERO_SPACE = 1250;
+const uint32_t SYMPHONY_ONE_MARK = SYMPHONY_ZERO_SPACE;
+const uint32_t SYMPHONY_ONE_SPACE = SYMPHONY_ZERO_MARK;
+const uint32_t SYMPHONY_FOOTER_GAP = 4 * (SYMPHONY_ONE_MARK + SYMPHONY_ONE_SPACE);
+
+// Sharp A/C
+const uint32_t SHARP_AC_HDR_MARK = 3800;
+const uint32_t SHARP_AC_HDR_SPACE = 1900;
+const uint32_t SHARP_AC_BIT_MARK = 470;
+const uint32_t SHARP_AC_ZERO_SPACE = 500;
+const uint32_t SHARP_AC_ONE_SPACE = 1400;
+const uint32_t SHARP_AC_GAP = 100000;
+
+// Daikin64
+const uint32_t DAIKIN64_LDR_MARK = 9800;
+const uint32_t DAIKIN64_LDR_SPACE = 9800;
+const uint32_t DAIKIN64_HDR_MARK = 4600;
+const uint32_t DAIKIN64_HDR_SPACE = 2500;
+const uint32_t DAIKIN64_BIT_MARK = 350;
+const uint32_t DAIKIN64_ONE_SPACE = 954;
+const uint32_t DAIKIN64_ZERO_SPACE = 382;
+const uint32_t DAIKIN64_GAP = 20300;
+const uint32_t DAIKIN64_MESSAGE_GAP = 100000;
+
+/*=================================== RENDERING ==================================*/
+// Collects durations; consecutive marks or spaces are merged like the LED would see them
+struct TimingBuffer {
+  uint32_t *timings;
+  uint16_t max;
+  uint16_t count;
+  uint32_t total;  // Sum of all durations (us)
+  bool overflow;
+};
+
+void addTiming(TimingBuffer &buffer, bool mark, uint32_t duration) {
+  if (duration == 0) return;
+  buffer.total += duration;
+
+  if (buffer.count == 0 && !mark) return;  // A leading space sends nothing
+  bool lastIsMark = buffer.count % 2 == 1;
+  if (buffer.count > 0 && lastIsMark == mark) {
+    buffer.timings[buffer.count - 1] += duration;
+    return;
+  }
+  if (buffer.count >= buffer.max) {
+    buffer.overflow = true;
+    return;
+  }
+  buffer.timings[buffer.count++] = duration;
+}
+
+void addMark(TimingBuffer &buffer, uint32_t duration) { addTiming(buffer, true, duration); }
+void addSpace(TimingBuffer &buffer, uint32_t duration) { addTiming(buffer, false, duration); }
+
+// Pulse distance/width encoding of nbits of data
+void addData(TimingBuffer &buffer, uint32_t oneMark, uint32_t oneSpace, uint32_t zeroMark, uint32_t zeroSpace, uint64_t data, uint8_t nbits, bool msbFirst) {
+  for (uint8_t i = 0; i < nbits; i++) {
+    uint8_t bit = msbFirst ? nbits - 1 - i : i;
+    if ((data >> bit) & 1) {
+      addMark(buffer, oneMark);
+      addSpace(buffer, oneSpace);
+    } else {
+      addMark(buffer, zeroMark);
+      addSpace(buffer, zeroSpace);
+    }
+  }
+}
+
+// Space that pads a message to at least minLength (us) measured from messageStart
+void addGap(TimingBuffer &buffer, uint32_t messageStart, uint32_t minGap, uint32_t minLength) {
+  uint32_t elapsed = buffer.total - messageStart;
+  addSpace(buffer, max(minGap, elapsed < minLength ? minLength - elapsed : 0));
+}
+
+void renderNec(TimingBuffer &buffer, const IrCommand &command) {
+  uint32_t start = buffer.total;
+  addMark(buffer, NEC_HDR_MARK);
+  addSpace(buffer, NEC_HDR_SPACE);
+  addData(buffer, NEC_BIT_MARK, NEC_ONE_SPACE, NEC_BIT_MARK, NEC_ZERO_SPACE, command.data, command.nbits, true);
+  addMark(buffer, NEC_BIT_MARK);
+  addGap(buffer, start, NEC_MIN_GAP, NEC_MIN_COMMAND_LENGTH);
+
+  // NEC repeats are the short repeat code
+  for (uint8_t r = 0; r < command.repeat; r++) {
+    start = buffer.total;
+    addMark(buffer, NEC_HDR_MARK);
+    addSpace(buffer, NEC_RPT_SPACE);
+    addMark(buffer, NEC_BIT_MARK);
+    addGap(buffer, start, NEC_MIN_GAP, NEC_MIN_COMMAND_LENGTH);
+  }
+}
+
+void renderRc6(TimingBuffer &buffer, const IrCommand &command) {
+  for (uint8_t r = 0; r <= command.repeat; r++) {
+    addMark(buffer, RC6_HDR_MARK);
+    addSpace(buffer, RC6_HDR_SPACE);
+    addMark(buffer, RC6_TICK);  // Start bit (always 1)
+    addSpace(buffer, RC6_TICK);
+
+    // Manchester coded, MSB first. The 4th bit (trailer/toggle) is double length.
+    for (uint8_t i = 1; i <= command.nbits; i++) {
+      uint32_t bitTime = i == 4 ? 2 * RC6_TICK : RC6_TICK;
+      if ((command.data >> (command.nbits - i)) & 1) {
+        addMark(buffer, bitTime);
+        addSpace(buffer, bitTime);
+      } else {
+        addSpace(buffer, bitTime);
+        addMark(buffer, bitTime);
+      }
+    }
+    addSpace(buffer, RC6_RPT_LENGTH);
+  }
+}
+
+void renderSymphony(TimingBuffer &buffer, const IrCommand &command) {
+  for (uint8_t r = 0; r <= command.repeat; r++) {
+    addData(buffer, SYMPHONY_ONE_MARK, SYMPHONY_ONE_SPACE, SYMPHONY_ZERO_MARK, SYMPHONY_ZERO_SPACE, command.data, command.nbits, true);
+    addSpace(buffer, SYMPHONY_FOOTER_GAP);
+  }
+}
+
+void renderSharpAc(TimingBuffer &buffer, const IrCommand &command) {
+  for (uint8_t r = 0; r <= command.repeat; r++) {
+    addMark(buffer, SHARP_AC_HDR_MARK);
+    addSpace(buffer, SHARP_AC_HDR_SPACE);
+    for (uint8_t i = 0; i < command.nbytes; i++) {
+      addData(buffer, SHARP_AC_BIT_MARK, SHARP_AC_ONE_SPACE, SHARP_AC_BIT_MARK, SHARP_AC_ZERO_SPACE, command.state[i], 8, false);
+    }
+    addMark(buffer, SHARP_AC_BIT_MARK);
+    addSpace(buffer, SHARP_AC_GAP);
+  }
+}
+
+void renderDaikin64(TimingBuffer &buffer, const IrCommand &command) {
+  for (uint8_t r = 0; r <= command.repeat; r++) {
+    for (uint8_t i = 0; i < 2; i++) {
+      addMark(buffer, DAIKIN64_LDR_MARK);
+      addSpace(buffer, DAIKIN64_LDR_SPACE);
+    }
+    addMark(buffer, DAIKIN64_HDR_MARK);
+    addSpace(buffer, DAIKIN64_HDR_SPACE);
+    addData(buffer, DAIKIN64_BIT_MARK, DAIKIN64_ONE_SPACE, DAIKIN64_BIT_MARK, DAIKIN64_ZERO_SPACE, command.data, command.nbits, false);
+    addMark(buffer, DAIKIN64_BIT_MARK);
+    addSpace(buffer, DAIKIN64_GAP);
+    addMark(buffer, DAIKIN64_HDR_MARK);
+    addSpace(buffer, DAIKIN64_MESSAGE_GAP);
+  }
+}
+
+uint16_t irRenderTimings(const IrCommand &command, uint32_t *timings, uint16_t maxTimings, uint32_t &frequency, uint8_t &dutyCycle) {
+  TimingBuffer buffer = {timings, maxTimings, 0, 0, false};
+
+  switch (command.protocol) {
+    case IR_PROTOCOL_NEC:
+      frequency = 38000;
+      dutyCycle = 33;
+      renderNec(buffer, command);
+      break;
+    case IR_PROTOCOL_RC6:
+      frequency = 36000;
+      dutyCycle = 33;
+      renderRc6(buffer, command);
+      break;
+    case IR_PROTOCOL_SYMPHONY:
+      frequency = 38000;
+      dutyCycle = 50;
+      renderSymphony(buffer, command);
+      break;
+    case IR_PROTOCOL_SHARP_AC:
+      frequency = 38000;
+      dutyCycle = 50;
+      renderSharpAc(buffer, command);
+      break;
+    case IR_PROTOCOL_DAIKIN64:
+      frequency = 38000;
+      dutyCycle = 50;
+      renderDaikin64(buffer, command);
+      break;
+  }
+  return buffer.overflow ? 0 : buffer.count;
+}
+
+IrCommand irCodeCommand(IrProtocol protocol, uint64_t data, uint8_t nbits, uint8_t repeat) {
+  IrCommand command = {};
+  command.protocol = protocol;
+  command.data = data;
+  command.nbits = nbits;
+  command.repeat = repeat;
+  return command;
+}
+
+IrCommand irStateCommand(IrProtocol protocol, const uint8_t *state, uint8_t nbytes, uint8_t repeat) {
+  IrCommand command = {};
+  command.protocol = protocol;
+  command.nbytes = min(nbytes, IR_STATE_MAX_BYTES);
+  command.repeat = repeat;
+  memcpy(command.state, state, command.nbytes);
+  return command;
+}
+
+/*=================================== EMITTERS ===================================*/
+const uint8_t IR_EMITTER_QUEUE = 4;
+const uint16_t IR_MAX_ITEMS = 160;
+const uint32_t RMT_MAX_DURATION = 32767;  // 15-bit duration field, 1 tick = 1 us
+const uint32_t RMT_SOURCE_CLOCK = 80000000;  // APB clock feeding the carrier generator
+
+struct IrEmitter {
+  rmt_channel_t channel;
+  bool busy;
+  uint8_t queueHead;
+  uint8_t queueCount;
+  IrCommand queue[IR_EMITTER_QUEUE];
+  uint32_t timings[IR_MAX_TIMINGS];
+  rmt_item32_t items[IR_MAX_ITEMS];  // Must stay valid until the channel is done (the driver refills from it)
+};
+
+IrEmitter irEmitters[IR_EMITTER_COUNT];
+bool irEmittersReady = false;
+IrCaptureHook irCaptureHook = nullptr;
+bool irCarrierEnabled = true;
+bool irFlushDeferred = false;
+
+void initIrEmitters() {
+  if (irEmittersReady) return;
+
+  for (uint8_t i = 0; i < IR_EMITTER_COUNT; i++) {
+    rmt_config_t config = RMT_DEFAULT_CONFIG_TX((gpio_num_t)IR_EMITTER_PINS[i], (rmt_channel_t)i);
+    config.clk_div = 80;  // 1 us per tick
+    config.tx_config.carrier_en = true;
+    config.tx_config.carrier_freq_hz = 38000;
+    config.tx_config.carrier_duty_percent = 50;
+    config.tx_config.carrier_level = RMT_CARRIER_LEVEL_HIGH;
+    config.tx_config.idle_output_en = true;
+    config.tx_config.idle_level = RMT_IDLE_LEVEL_LOW;
+    rmt_config(&config);
+    rmt_driver_install(config.channel, 0, 0);
+
+    irEmitters[i].channel = config.channel;
+    irEmitters[i].busy = false;
+    irEmitters[i].queueHead = 0;
+    irEmitters[i].queueCount = 0;
+  }
+  irEmittersReady = true;
+}
+
+// Converts mark/space durations into RMT items, splitting durations longer than one item half
+uint16_t buildItems(IrEmitter &emitter, uint16_t timingCount) {
+  uint16_t itemCount = 0;
+  bool secondHalf = false;
+
+  for (uint16_t i = 0; i < timingCount; i++) {
+    uint32_t remaining = emitter.timings[i];
+    uint32_t level = i % 2 == 0 ? 1 : 0;
+
+    while (remaining > 0) {
+      uint32_t duration = min(remaining, RMT_MAX_DURATION);
+      remaining -= duration;
+
+      if (!secondHalf) {
+        if (itemCount >= IR_MAX_ITEMS) return 0;
+        emitter.items[itemCount].level0 = level;
+        emitter.items[itemCount].duration0 = duration;
+        emitter.items[itemCount].level1 = 0;
+        emitter.items[itemCount].duration1 = 0;
+        itemCount++;
+      } else {
+        emitter.items[itemCount - 1].level1 = level;
+        emitter.items[itemCount - 1].duration1 = duration;
+      }
+      secondHalf = !secondHalf;
+    }
+  }
+  return itemCount;
+}
+
+// Render the next queued command of an emitter and start it without waiting
+void startNextCommand(IrEmitter &emitter) {
+  while (emitter.queueCount > 0) {
+    const IrCommand &command = emitter.queue[emitter.queueHead];
+    emitter.queueHead = (emitter.queueHead + 1) % IR_EMITTER_QUEUE;
+    emitter.queueCount--;
+
+    uint32_t frequency;
+    uint8_t dutyCycle;
+    uint16_t timingCount = irRenderTimings(command, emitter.timings, IR_MAX_TIMINGS, frequency, dutyCycle);
+    uint16_t itemCount = timingCount ? buildItems(emitter, timingCount) : 0;
+    if (itemCount == 0) continue;  // Does not fit, skip it
+
+    uint32_t period = RMT_SOURCE_CLOCK / frequency;
+    uint16_t high = period * dutyCycle / 100;
+    rmt_set_tx_carrier(emitter.channel, irCarrierEnabled, high, period - high, RMT_CARRIER_LEVEL_HIGH);
+    rmt_write_items(emitter.channel, emitter.items, itemCount, false);
+    emitter.busy = true;
+    metrics.irFrames++;
+    return;
+  }
+}
+
+bool irQueue(IrAppliance appliance, const IrCommand &command) {
+  if (irCaptureHook != nullptr && irCaptureHook(appliance, command)) return true;
+  initIrEmitters();
+
+  IrEmitter &emitter = irEmitters[irApplianceEmitter[appliance]];
+  if (emitter.queueCount >= IR_EMITTER_QUEUE) return false;
+
+  emitter.queue[(emitter.queueHead + emitter.queueCount) % IR_EMITTER_QUEUE] = command;
+  emitter.queueCount++;
+  return true;
+}
+
+bool irPoll() {
+  if (!irEmittersReady) return false;
+  bool active = false;
+
+  for (uint8_t i = 0; i < IR_EMITTER_COUNT; i++) {
+    IrEmitter &emitter = irEmitters[i];
+
+    if (emitter.busy && rmt_wait_tx_done(emitter.channel, 0) == ESP_OK) emitter.busy = false;
+    if (!emitter.busy) startNextCommand(emitter);  // Each emitter moves on as soon as it is free
+    if (emitter.busy) active = true;
+  }
+  return active;
+}
+
+void irFlush() {
+  while (irPoll()) {
+    if (irFlushDeferred) return;  // Started, irPoll() in loop() sends the rest
+    delay(1);
+  }
+}
+
+void irEmit(IrAppliance appliance, const IrCommand &command) {
+  irQueue(appliance, command);
+  irFlush();
+}
@@ -0,0 +1,79 @@
+#ifndef IR_EMITTER_H
+#define IR_EMITTER_H
+
+#include <stdint.h>
+
+// IR output through the ESP32 RMT peripheral
+// Every emitter (IR LED pin) has its own RMT channel and carrier generator, so frames queued for
+// different emitters are transmitted at the same time and a burst takes as long as the longest
+// frame instead of the sum of all frames. Frames queued for the same emitter go out one after another.
+
+extern const uint8_t IR_LED;
+
+const uint8_t IR_EMITTER_COUNT = 3;
+
+enum IrProtocol : uint8_t {
+  IR_PROTOCOL_NEC,
+  IR_PROTOCOL_RC6,
+  IR_PROTOCOL_SYMPHONY,
+  IR_PROTOCOL_SHARP_AC,
+  IR_PROTOCOL_DAIKIN64,
+};
+
+// Appliance registry: every appliance is assigned to one emitter (see irApplianceEmitter in ir_emitter.cpp)
+// The map depends on the installation: each LED must point at the appliances assigned to it. The default
+// wiring has the original LED on IR_LED aimed at the TV corner and two more LEDs on GPIO 16 and 4:
+//   emitter 0 (IR_LED): LG TV, Astro, Sharp A/C
+//   emitter 1 (GPIO 16): FFT fan, Daikin A/C
+//   emitter 2 (GPIO 4):  Deka fan
+// With a single LED, set every entry to 0: everything still works, only one frame is sent at a time.
+enum IrAppliance : uint8_t {
+  IR_DEKA_FAN,
+  IR_FFT_FAN,
+  IR_LG_TV,
+  IR_ASTRO,
+  IR_SHARP_AC,
+  IR_DAIKIN_AC,
+  IR_APPLIANCE_COUNT,
+};
+
+const uint8_t IR_STATE_MAX_BYTES = 13;  // Sharp A/C state length
+
+// One IR message. Codes use data/nbits, A/C states use state/nbytes.
+struct IrCommand {
+  IrProtocol protocol;
+  uint8_t nbits;
+  uint8_t repeat;
+  uint64_t data;
+  uint8_t nbytes;
+  uint8_t state[IR_STATE_MAX_BYTES];
+};
+
+const uint16_t IR_MAX_TIMINGS = 256;
+
+// Renders a command into alternating mark/space durations in microseconds (starting with a mark),
+// the same timings IRremoteESP8266 would produce. Returns the number of durations, 0 on overflow.
+uint16_t irRenderTimings(const IrCommand &command, uint32_t *timings, uint16_t maxTimings, uint32_t &frequency, uint8_t &dutyCycle);
+
+IrCommand irCodeCommand(IrProtocol protocol, uint64_t data, uint8_t nbits, uint8_t repeat = 0);
+IrCommand irStateCommand(IrProtocol protocol, const uint8_t *state, uint8_t nbytes, uint8_t repeat = 0);
+
+extern uint8_t irApplianceEmitter[IR_APPLIANCE_COUNT];  // Emitter index per appliance
+
+// Verification hooks (see ir_verify.h)
+typedef bool (*IrCaptureHook)(IrAppliance appliance, const IrCommand &command);
+extern IrCaptureHook irCaptureHook;  // When set and it returns true, queued commands are not transmitted
+extern bool irCarrierEnabled;         // Disabled to transmit the bare envelope for loopback capture
+
+void initIrEmitters();  // Safe to call more than once
+bool irQueue(IrAppliance appliance, const IrCommand &command);  // Returns false when the emitter queue is full
+void irFlush();  // Transmits everything queued and returns when all emitters are done
+// Starts queued frames on the emitters that are free without waiting. Returns true while any emitter
+// is still transmitting (then call it again, e.g. from loop()).
+bool irPoll();
+// When set, irFlush() and irEmit() start the transmission and return right away (serial_command.cpp
+// sets it so loop() never waits for a frame)
+extern bool irFlushDeferred;
+void irEmit(IrAppliance appliance, const IrCommand &command);  // Queue and flush a single command
+
+#endif
@@ -1,18 +1,15 @@
 #include "ir_general.h"
 
-#include <IRremoteESP8266.h>
-#include <IRsend.h>
-
-// Instances for sending IR signals
-IRsend irSend(IR_LED);
+#include "ir_aircond.h"
+#include "ir_emitter.h"
 
 // Initialize the IR Sender
 void initIrGeneral() {
-  irSend.begin();
+  initIrEmitters();
 }
 
 /*================================RC6 PROTOCOL==============================*/
-void sendRC6(RC6Command& command, uint16_t nbits, uint16_t repeat = 0) {
+void sendRC6(IrAppliance appliance, RC6Command& command, uint16_t nbits, uint16_t repeat = 0) {
   uint64_t toggleBitCode = command.code;  // Default to the original code
   uint8_t shift = (nbits == 36) ? 15 : (nbits == 20) ? 16 : 0;
 
@@ -24,7 +21,7 @@ void sendRC6(RC6Command& command, uint16_t nbits, uint16_t repeat = 0) {
     command.toggle = !command.toggle;  // Flip the toggle state
   }
 
-  irSend.sendRC6(toggleBitCode, nbits, repeat);
+  irEmit(appliance, irCodeCommand(IR_PROTOCOL_RC6, toggleBitCode, nbits, repeat));
 }
 
 // Astro TV RC6 36 bits
@@ -45,20 +42,30 @@ RC6Command tvAstroButtonEight = {0xC80562708};
 RC6Command tvAstroButtonNine = {0xC80562709};
 RC6Command tvAstroButtonZero = {0xC80562700};
 
-void sendAstroTv(RC6Command& command) { sendRC6(command, 36, 1); }
+void sendAstroTv(RC6Command& command) { sendRC6(IR_ASTRO, command, 36, 1); }
 
 /*==============================NEC PROTOCOL===========================*/
-void sendNEC(uint64_t command, uint16_t nbits, uint16_t repeat = 0) {
-  irSend.sendNEC(command, nbits, repeat);
+void sendNEC(IrAppliance appliance, uint64_t command, uint16_t nbits, uint16_t repeat = 0) {
+  irEmit(appliance, irCodeCommand(IR_PROTOCOL_NEC, command, nbits, repeat));
 }
 
-void sendLGTV(uint64_t command) { sendNEC(command, 32); }
+void sendLGTV(uint64_t command) { sendNEC(IR_LG_TV, command, 32); }
 
 /*===========================SYMPHONY PROTOCOL=========================*/
-void sendSymphony(uint32_t command, uint16_t nbits, uint16_t repeat = 0) {
-  irSend.sendSymphony(command, nbits, repeat);
+void sendSymphony(IrAppliance appliance, uint32_t command, uint16_t nbits, uint16_t repeat = 0) {
+  irEmit(appliance, irCodeCommand(IR_PROTOCOL_SYMPHONY, command, nbits, repeat));
 }
 
-void sendDekaFan(uint32_t command) { sendSymphony(command, 12, 1); }
+void sendDekaFan(uint32_t command) { sendSymphony(IR_DEKA_FAN, command, 12, 1); }
+
+void sendFFTFan(uint32_t command) { sendSymphony(IR_FFT_FAN, command, 12, 1); }
 
-void sendFFTFan(uint32_t command) { sendSymphony(command, 12, 1); }
\ No newline at end of file
+/*=============================POWER OFF BURST=========================*/
+// Only appliances with a discrete off code are included, toggles could switch something on.
+// Appliances on different emitters are sent at the same time.
+void irPowerOffAll() {
+  irQueue(IR_DEKA_FAN, irCodeCommand(IR_PROTOCOL_SYMPHONY, fanDekaPowerOff, 12, 1));
+  irQueue(IR_FFT_FAN, irCodeCommand(IR_PROTOCOL_SYMPHONY, fanFFTPowerOff, 12, 1));
+  sharpAcQueuePowerOff();
+  irFlush();
+}
\ No newline at end of file
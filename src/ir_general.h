@@ -57,5 +57,6 @@ void sendLGTV(uint64_t command);  // irSend LG TV
 void sendDekaFan(uint32_t command);  // irSend Deka fan
 void sendFFTFan(uint32_t command);  // irSend FFT fan
 void sendAstroTv(RC6Command &command);  // irSend astro (Satellite TV) decoder
+void irPowerOffAll();  // Turns off every appliance with a discrete off code in one burst
 
 #endif
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include "ir_render_check.h"
+
+#include <Arduino.h>
+
+#include "ir_aircond.h"
+#include "ir_general.h"
+
+/*================================ GOLDEN TIMINGS ================================*/
+// Timings (us) from the protocol descriptions, kept independent from the ir_emitter renderer
+struct PulseCoding {
+  uint32_t hdrMark, hdrSpace;
+  uint32_t oneMark, oneSpace;
+  uint32_t zeroMark, zeroSpace;
+  uint32_t footerMark;
+  uint32_t minGap;
+};
+
+const PulseCoding NEC_SPEC = {9000, 4500, 562, 1687, 562, 562, 562, 0};
+const uint32_t NEC_SPEC_FRAME_LENGTH = 108000;  // Frame period, the gap fills it up
+const PulseCoding SYMPHONY_SPEC = {0, 0, 1250, 400, 400, 1250, 0, 6600};
+const PulseCoding SHARP_AC_SPEC = {3800, 1900, 470, 1400, 470, 500, 470, 100000};
+const PulseCoding DAIKIN64_SPEC = {4600, 2500, 350, 954, 350, 382, 350, 20300};
+const uint32_t DAIKIN64_SPEC_LEADER = 9800;  // Two leader mark/space pairs before the header
+const uint32_t DAIKIN64_SPEC_MESSAGE_GAP = 100000;
+const uint32_t RC6_SPEC_TICK = 444;  // 16 carrier periods at 36 kHz
+const uint32_t RC6_SPEC_MIN_GAP = 6 * RC6_SPEC_TICK;  // Signal free time
+
+const uint8_t MAX_REPORTED_VIOLATIONS = 8;
+
+void addPulse(PulseSequence &sequence, bool mark, uint32_t duration, bool gap = false) {
+  if (duration == 0) return;
+  sequence.total += duration;
+  if (sequence.count == 0 && !mark) return;
+
+  bool lastIsMark = sequence.count % 2 == 1;
+  if (sequence.count > 0 && lastIsMark == mark) {
+    sequence.duration[sequence.count - 1] += duration;
+    sequence.gap[sequence.count - 1] |= gap;
+    return;
+  }
+  if (sequence.count >= IR_MAX_TIMINGS) {
+    sequence.overflow = true;
+    return;
+  }
+  sequence.duration[sequence.count] = duration;
+  sequence.gap[sequence.count] = gap;
+  sequence.count++;
+}
+
+void addCodedBits(PulseSequence &sequence, const PulseCoding &spec, uint64_t data, uint8_t nbits, bool msbFirst) {
+  for (uint8_t i = 0; i < nbits; i++) {
+    bool one = (data >> (msbFirst ? nbits - 1 - i : i)) & 1;
+    addPulse(sequence, true, one ? spec.oneMark : spec.zeroMark);
+    addPulse(sequence, false, one ? spec.oneSpace : spec.zeroSpace);
+  }
+}
+
+void buildGolden(const IrCommand &command, PulseSequence &sequence) {
+  memset(&sequence, 0, sizeof(sequence));
+
+  for (uint8_t r = 0; r <= command.repeat; r++) {
+    uint32_t start = sequence.total;
+
+    switch (command.protocol) {
+      case IR_PROTOCOL_NEC:
+        addPulse(sequence, true, NEC_SPEC.hdrMark);
+        addPulse(sequence, false, NEC_SPEC.hdrSpace);
+        addCodedBits(sequence, NEC_SPEC, command.data, command.nbits, true);
+        addPulse(sequence, true, NEC_SPEC.footerMark);
+        addPulse(sequence, false, NEC_SPEC_FRAME_LENGTH - (sequence.total - start), true);
+        break;
+
+      case IR_PROTOCOL_RC6:
+        addPulse(sequence, true, 6 * RC6_SPEC_TICK);
+        addPulse(sequence, false, 2 * RC6_SPEC_TICK);
+        addPulse(sequence, true, RC6_SPEC_TICK);  // Start bit
+        addPulse(sequence, false, RC6_SPEC_TICK);
+        for (uint8_t i = 0; i < command.nbits; i++) {
+          uint32_t bitTime = i == 3 ? 2 * RC6_SPEC_TICK : RC6_SPEC_TICK;  // Trailer bit
+          bool one = (command.data >> (command.nbits - 1 - i)) & 1;
+          addPulse(sequence, one, bitTime);
+          addPulse(sequence, !one, bitTime);
+        }
+        addPulse(sequence, false, RC6_SPEC_MIN_GAP, true);
+        break;
+
+      case IR_PROTOCOL_SYMPHONY:
+        addCodedBits(sequence, SYMPHONY_SPEC, command.data, command.nbits, true);
+        addPulse(sequence, false, SYMPHONY_SPEC.minGap, true);
+        break;
+
+      case IR_PROTOCOL_SHARP_AC:
+        addPulse(sequence, true, SHARP_AC_SPEC.hdrMark);
+        addPulse(sequence, false, SHARP_AC_SPEC.hdrSpace);
+        for (uint8_t i = 0; i < command.nbytes; i++) addCodedBits(sequence, SHARP_AC_SPEC, command.state[i], 8, false);
+        addPulse(sequence, true, SHARP_AC_SPEC.footerMark);
+        addPulse(sequence, false, SHARP_AC_SPEC.minGap, true);
+        break;
+
+      case IR_PROTOCOL_DAIKIN64:
+        for (uint8_t i = 0; i < 2; i++) {
+          addPulse(sequence, true, DAIKIN64_SPEC_LEADER);
+          addPulse(sequence, false, DAIKIN64_SPEC_LEADER);
+        }
+        addPulse(sequence, true, DAIKIN64_SPEC.hdrMark);
+        addPulse(sequence, false, DAIKIN64_SPEC.hdrSpace);
+        addCodedBits(sequence, DAIKIN64_SPEC, command.data, command.nbits, false);
+        addPulse(sequence, true, DAIKIN64_SPEC.footerMark);
+        addPulse(sequence, false, DAIKIN64_SPEC.minGap);
+        addPulse(sequence, true, DAIKIN64_SPEC.hdrMark);
+        addPulse(sequence, false, DAIKIN64_SPEC_MESSAGE_GAP, true);
+        break;
+    }
+  }
+}
+
+// Replace spaces longer than the RX idle threshold by separators, like an RX capture sees them.
+// Golden gaps only give a minimum, so they split where the rendered frame (reference) splits.
+// The final space runs into idle and is never captured.
+void splitAtIdle(PulseSequence &sequence, const PulseSequence *reference) {
+  for (uint16_t i = 1; i < sequence.count; i += 2) {
+    bool referenceSplits = reference != nullptr && sequence.gap[i] && i < reference->count && reference->duration[i] >= IR_RX_IDLE_THRESHOLD;
+    if (sequence.duration[i] >= IR_RX_IDLE_THRESHOLD || referenceSplits) {
+      sequence.duration[i] = 0;
+      sequence.gap[i] = false;
+    }
+  }
+  if (sequence.count > 0 && sequence.count % 2 == 0) sequence.count--;
+}
+
+/*==================================== REPORT ====================================*/
+const char *protocolName(IrProtocol protocol) {
+  switch (protocol) {
+    case IR_PROTOCOL_NEC: return "NEC";
+    case IR_PROTOCOL_RC6: return "RC6";
+    case IR_PROTOCOL_SYMPHONY: return "Symphony";
+    case IR_PROTOCOL_SHARP_AC: return "Sharp AC";
+    case IR_PROTOCOL_DAIKIN64: return "Daikin64";
+  }
+  return "?";
+}
+
+// Compares actual pulses with the golden timings and, when given, the rendered frame (jitter).
+// Prints one summary line plus the violations. Returns true when everything is within tolerance.
+bool comparePulses(const char *phase, const CapturedCommand &entry, const PulseSequence &golden, const PulseSequence &actual, const PulseSequence *reference) {
+  uint16_t count = min(golden.count, actual.count);
+  uint16_t violations = 0;
+  uint32_t maxDrift = 0, maxJitter = 0, jitterSum = 0;
+  uint16_t maxDriftPulse = 0;
+  bool structureOk = golden.count == actual.count;
+
+  for (uint16_t i = 0; i < count; i++) {
+    uint32_t expected = golden.duration[i];
+    uint32_t measured = actual.duration[i];
+
+    if (expected == 0 || measured == 0) {  // Capture separator
+      if (expected != measured) structureOk = false;
+      continue;
+    }
+
+    uint32_t drift = measured > expected ? measured - expected : expected - measured;
+    bool violation = golden.gap[i] ? measured * 100 < expected * (100 - IR_TOLERANCE_PERCENT)
+                                   : drift * 100 > expected * IR_TOLERANCE_PERCENT;
+    if (!golden.gap[i] && drift > maxDrift) {
+      maxDrift = drift;
+      maxDriftPulse = i;
+    }
+    if (reference != nullptr && i < reference->count) {
+      uint32_t jitter = measured > reference->duration[i] ? measured - reference->duration[i] : reference->duration[i] - measured;
+      maxJitter = max(maxJitter, jitter);
+      jitterSum += jitter;
+    }
+    if (violation && violations++ < MAX_REPORTED_VIOLATIONS) {
+      Serial.printf("    %s pulse %u (%s): expected %s%luus got %luus (%+ld%%)\n", entry.label, i, i % 2 == 0 ? "mark" : "space",
+                    golden.gap[i] ? ">=" : "", (unsigned long)expected, (unsigned long)measured,
+                    (long)(((int64_t)measured - expected) * 100 / (int64_t)expected));
+    }
+  }
+
+  bool passed = structureOk && violations == 0;
+  Serial.printf("[%s] %s %s (%s ", passed ? "PASS" : "FAIL", phase, entry.label, protocolName(entry.command.protocol));
+  if (entry.command.nbytes > 0) Serial.printf("%u bytes", entry.command.nbytes);
+  else Serial.printf("0x%llX", (unsigned long long)entry.command.data);
+  Serial.printf("): %u pulses, max drift %luus at pulse %u", actual.count, (unsigned long)maxDrift, maxDriftPulse);
+  if (reference != nullptr) Serial.printf(", jitter max %luus mean %.1fus", (unsigned long)maxJitter, count ? (float)jitterSum / count : 0.0f);
+  Serial.println();
+  if (!structureOk) Serial.printf("    %s: expected %u pulses got %u\n", entry.label, golden.count, actual.count);
+  if (violations > MAX_REPORTED_VIOLATIONS) Serial.printf("    ... %u more\n", violations - MAX_REPORTED_VIOLATIONS);
+  return passed;
+}
+
+/*================================= RENDER CHECK =================================*/
+IrCheckBuffers *captureBuffers = nullptr;
+const char *captureLabel = "";
+
+bool captureCommand(IrAppliance appliance, const IrCommand &command) {
+  IrCheckBuffers &buffers = *captureBuffers;
+  if (buffers.capturedCount < IR_MAX_CAPTURED_COMMANDS) buffers.captured[buffers.capturedCount++] = {captureLabel, appliance, command};
+  return true;  // Nothing leaves the LED while capturing
+}
+
+void captureSendPaths(IrCheckBuffers &buffers) {
+  IrCaptureHook previousHook = irCaptureHook;
+  buffers.capturedCount = 0;
+  captureBuffers = &buffers;
+  irCaptureHook = captureCommand;
+
+  captureLabel = "LG TV Power";
+  sendLGTV(tvLGPowerToggle);
+  captureLabel = "Astro Power";
+  sendAstroTv(tvAstroPowerToggle);
+  captureLabel = "Astro Power (toggle)";
+  sendAstroTv(tvAstroPowerToggle);
+  captureLabel = "Deka Fan Off";
+  sendDekaFan(fanDekaPowerOff);
+  captureLabel = "FFT Fan Speed 1";
+  sendFFTFan(fanFFTSpeedOne);
+  captureLabel = "Sharp A/C Power";
+  sharpAcPowerToggle();
+  captureLabel = "Sharp A/C Power (restore)";
+  sharpAcPowerToggle();
+  captureLabel = "Daikin A/C Power";
+  daikinAcPowerToggle();
+
+  irCaptureHook = previousHook;
+  captureBuffers = nullptr;
+}
+
+void renderSequence(const IrCommand &command, PulseSequence &sequence) {
+  uint32_t frequency;
+  uint8_t dutyCycle;
+  memset(&sequence, 0, sizeof(sequence));
+  sequence.count = irRenderTimings(command, sequence.duration, IR_MAX_TIMINGS, frequency, dutyCycle);
+}
+
+uint16_t runRenderCheck(IrCheckBuffers &buffers) {
+  uint16_t failures = 0;
+
+  for (uint8_t i = 0; i < buffers.capturedCount; i++) {
+    const CapturedCommand &entry = buffers.captured[i];
+    buildGolden(entry.command, buffers.golden);
+    renderSequence(entry.command, buffers.rendered);
+    if (!comparePulses("render", entry, buffers.golden, buffers.rendered, nullptr)) failures++;
+  }
+
+  // sendRC6() must flip exactly bit 15 of a 36-bit code between two presses
+  if (buffers.capturedCount >= 3) {
+    uint64_t difference = buffers.captured[1].command.data ^ buffers.captured[2].command.data;
+    bool passed = difference == (1ULL << 15);
+    Serial.printf("[%s] render RC6 toggle bit: 0x%llX -> 0x%llX\n", passed ? "PASS" : "FAIL",
+                  (unsigned long long)buffers.captured[1].command.data, (unsigned long long)buffers.captured[2].command.data);
+    if (!passed) failures++;
+  }
+  return failures;
+}
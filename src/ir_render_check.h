@@ -0,0 +1,53 @@
+#ifndef IR_RENDER_CHECK_H
+#define IR_RENDER_CHECK_H
+
+#include <stdint.h>
+
+#include "ir_emitter.h"
+
+// IR render check (first half of ir_verify.h)
+// The commands produced by every send path of ir_general.cpp and ir_aircond.cpp are captured before
+// transmission, rendered and compared pulse by pulse with golden timings built from the protocol
+// descriptions. Nothing here touches the hardware, so the simulator runs it too (test_ir_render_check).
+
+const uint8_t IR_TOLERANCE_PERCENT = 25;  // Same default tolerance as IRremoteESP8266 decoders
+const uint16_t IR_RX_IDLE_THRESHOLD = 30000;  // Longer spaces end an RMT RX capture
+const uint8_t IR_MAX_CAPTURED_COMMANDS = 10;
+
+// Mark/space durations. A zero duration separates two RX captures.
+struct PulseSequence {
+  uint32_t duration[IR_MAX_TIMINGS];
+  bool gap[IR_MAX_TIMINGS];  // Only the minimum length matters for gaps
+  uint16_t count;
+  uint32_t total;
+  bool overflow;
+};
+
+struct CapturedCommand {
+  const char *label;
+  IrAppliance appliance;
+  IrCommand command;
+};
+
+// Too large for the loop task stack, allocate it
+struct IrCheckBuffers {
+  CapturedCommand captured[IR_MAX_CAPTURED_COMMANDS];
+  uint8_t capturedCount;
+  PulseSequence golden;
+  PulseSequence rendered;
+  PulseSequence received;
+};
+
+void buildGolden(const IrCommand &command, PulseSequence &sequence);  // Timings from the protocol descriptions
+void renderSequence(const IrCommand &command, PulseSequence &sequence);  // Timings from irRenderTimings()
+// Replaces spaces an RX capture would not see by separators (reference: where golden gaps split)
+void splitAtIdle(PulseSequence &sequence, const PulseSequence *reference = nullptr);
+
+// Prints one summary line plus the pulses out of tolerance, with the jitter against reference when given.
+// Returns true when everything is within tolerance.
+bool comparePulses(const char *phase, const CapturedCommand &entry, const PulseSequence &golden, const PulseSequence &actual, const PulseSequence *reference);
+
+void captureSendPaths(IrCheckBuffers &buffers);  // Runs every send path once with the emitters disconnected
+uint16_t runRenderCheck(IrCheckBuffers &buffers);  // Returns the number of failed checks
+
+#endif
@@ -0,0 +1,129 @@
+#include "ir_verify.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <driver/rmt.h>
+#include <freertos/ringbuf.h>
+
+#include "ir_aircond.h"
+#include "ir_emitter.h"
+#include "ir_render_check.h"
+
+const rmt_channel_t LOOPBACK_CHANNEL = RMT_CHANNEL_4;  // Channels 0-2 are the emitters
+
+IrCheckBuffers *verify = nullptr;
+
+/*================================ LOOPBACK CHECK ================================*/
+volatile bool loadRunning = false;
+volatile bool loadStopped = true;
+volatile uint32_t loadIterations = 0;
+
+// Synthetic system load: Wi-Fi scans (radio + interrupts) and display refreshes (I2C)
+void loadTask(void *) {
+  WiFi.mode(WIFI_STA);
+  while (loadRunning) {
+    if (WiFi.scanComplete() != WIFI_SCAN_RUNNING) WiFi.scanNetworks(true);
+    u8g2.sendBuffer();
+    loadIterations++;
+  }
+  WiFi.scanDelete();
+  WiFi.mode(WIFI_OFF);
+  loadStopped = true;
+  vTaskDelete(nullptr);
+}
+
+// Append one RX capture, merging halves with the same level
+void appendCapture(PulseSequence &sequence, const rmt_item32_t *items, size_t itemCount) {
+  if (sequence.count > 0 && sequence.count < IR_MAX_TIMINGS) sequence.duration[sequence.count++] = 0;  // Separator
+  uint16_t segmentStart = sequence.count;
+
+  for (size_t i = 0; i < itemCount; i++) {
+    uint32_t halves[2][2] = {{items[i].level0, items[i].duration0}, {items[i].level1, items[i].duration1}};
+    for (uint8_t h = 0; h < 2; h++) {
+      if (halves[h][1] == 0) return;  // End marker
+      bool mark = halves[h][0] == 1;
+      bool lastIsMark = (sequence.count - segmentStart) % 2 == 1;
+      if (sequence.count == segmentStart && !mark) continue;
+      if (sequence.count > segmentStart && lastIsMark == mark) sequence.duration[sequence.count - 1] += halves[h][1];
+      else if (sequence.count < IR_MAX_TIMINGS) sequence.duration[sequence.count++] = halves[h][1];
+    }
+  }
+}
+
+bool loopbackCommand(RingbufHandle_t ringBuffer, const CapturedCommand &entry) {
+  memset(&verify->received, 0, sizeof(verify->received));
+
+  uint8_t emitter = irApplianceEmitter[entry.appliance];
+  irApplianceEmitter[entry.appliance] = 0;  // The loopback jumper is on emitter 0
+  rmt_rx_start(LOOPBACK_CHANNEL, true);
+  irEmit(entry.appliance, entry.command);
+  irApplianceEmitter[entry.appliance] = emitter;
+
+  size_t size;
+  rmt_item32_t *items;
+  while ((items = (rmt_item32_t *)xRingbufferReceive(ringBuffer, &size, pdMS_TO_TICKS(IR_RX_IDLE_THRESHOLD / 1000 + 20))) != nullptr) {
+    appendCapture(verify->received, items, size / sizeof(rmt_item32_t));
+    vRingbufferReturnItem(ringBuffer, items);
+  }
+  rmt_rx_stop(LOOPBACK_CHANNEL);
+
+  if (verify->received.count == 0) {
+    Serial.printf("[FAIL] loopback %s: nothing captured on pin %u (jumper missing?)\n", entry.label, IR_LOOPBACK_PIN);
+    return false;
+  }
+
+  buildGolden(entry.command, verify->golden);
+  renderSequence(entry.command, verify->rendered);
+  splitAtIdle(verify->golden, &verify->rendered);
+  splitAtIdle(verify->rendered);
+  return comparePulses("loopback", entry, verify->golden, verify->received, &verify->rendered);
+}
+
+uint16_t runLoopbackCheck() {
+  rmt_config_t config = RMT_DEFAULT_CONFIG_RX((gpio_num_t)IR_LOOPBACK_PIN, LOOPBACK_CHANNEL);
+  config.clk_div = 80;  // 1 us per tick
+  config.mem_block_num = 4;
+  config.rx_config.filter_en = true;
+  config.rx_config.filter_ticks_thresh = 200;  // Ignore glitches shorter than 2.5 us (APB ticks)
+  config.rx_config.idle_threshold = IR_RX_IDLE_THRESHOLD;
+  if (rmt_config(&config) != ESP_OK || rmt_driver_install(LOOPBACK_CHANNEL, 8192, 0) != ESP_OK) {
+    Serial.println("[FAIL] loopback: RMT RX channel unavailable");
+    return 1;
+  }
+  RingbufHandle_t ringBuffer;
+  rmt_get_ringbuf_handle(LOOPBACK_CHANNEL, &ringBuffer);
+
+  loadRunning = true;
+  loadStopped = false;
+  loadIterations = 0;
+  xTaskCreatePinnedToCore(loadTask, "irLoad", 4096, nullptr, 2, nullptr, 0);
+
+  // Without carrier the frames are invisible to the appliances but show the exact envelope
+  irCarrierEnabled = false;
+  uint16_t failures = 0;
+  for (uint8_t i = 0; i < verify->capturedCount; i++) {
+    if (!loopbackCommand(ringBuffer, verify->captured[i])) failures++;
+  }
+  irCarrierEnabled = true;
+
+  loadRunning = false;
+  while (!loadStopped) delay(10);
+  rmt_driver_uninstall(LOOPBACK_CHANNEL);
+  Serial.printf("Load task ran %lu Wi-Fi/I2C iterations during loopback\n", (unsigned long)loadIterations);
+  return failures;
+}
+
+uint16_t runIrVerification() {
+  verify = new IrCheckBuffers();
+  Serial.println("IR timing verification");
+
+  initIrEmitters();
+  captureSendPaths(*verify);
+  uint16_t failures = runRenderCheck(*verify);
+  failures += runLoopbackCheck();
+
+  Serial.printf("IR timing verification: %u commands, %u failed\n", verify->capturedCount, failures);
+  delete verify;
+  verify = nullptr;
+  return failures;
+}
@@ -5,9 +5,21 @@
 #include <U8g2lib.h>
 
 #include "ESPNOW.h"
+#include "delta_ota.h"
+#include "encoder_input.h"
+#include "heap_guard.h"
 #include "ir_aircond.h"
+#include "ir_emitter.h"
 #include "ir_general.h"
+#include "ir_verify.h"
+#include "metrics.h"
+#include "render_cache.h"
+#include "scheduler.h"
+#include "serial_command.h"
+#include "settings.h"
+#include "shortcuts.h"
 #include "utils.h"
+#include "websocket_client.h"
 
 // Debugging Configuration
 // Set DEBUG_ENABLE to 1️⃣ to enable debugging globally, or 0️⃣ to disable all debugging output.
@@ -18,6 +30,7 @@
 #define DEBUG_ENCODER 0          // 🎛️ Debug rotary encoder activity
 #define DEBUG_MENU_ITEM 0        // 📜 Debug menu navigation and selected items
 #define DEBUG_DISPLAY_TIMEOUT 0  // 💤 Debug display wake-up and timeout events
+#define DEBUG_IR_VERIFY 0        // 📡 Verify IR timings at boot (loopback needs a jumper to IR_LOOPBACK_PIN)
 
 // Define pin numbers
 #define STATUS_INDICATOR 2
@@ -111,25 +124,65 @@ MenuItem irSendMenu[] = {
   {"LG TV", LGTVMenu, nullptr, false},
   {"Astro", astroMenu, nullptr, false},
   {"Living Room Fan", FFTFanMenu, nullptr, false},
+  {"Power Off All", nullptr, irPowerOffAll, false},
   {"Back", nullptr, nullptr, false},  // Back button (ONLY FOR SUB-MENU)
   {nullptr, nullptr, nullptr, false}  // Count terminator. REQUIRED FOR EVERY MENU!
 };
 
 MenuItem homeAutomationMenu[] = {
-  {"Switch 1", nullptr, sendDataSwitch1, false},
-  {"Switch 2", nullptr, sendDataSwitch2, false},
-  {"Switch 3", nullptr, sendDataSwitch3, false},
-  {"Switch 4", nullptr, sendDataSwitch4, false},
+  {switchLabel[0], nullptr, sendDataSwitch1, false},
+  {switchLabel[1], nullptr, sendDataSwitch2, false},
+  {switchLabel[2], nullptr, sendDataSwitch3, false},
+  {switchLabel[3], nullptr, sendDataSwitch4, false},
   {"Back", nullptr, nullptr, false},  // Back button (ONLY FOR SUB-MENU)
   {nullptr, nullptr, nullptr, false}  // Count terminator. REQUIRED FOR EVERY MENU!
 };
 
+MenuItem webSocketMenu[] = {
+  {"Status", nullptr, webSocketStatusUI, true},
+  {"Switch 1", nullptr, []() { webSocketToggleSwitch(0); }, false},
+  {"Switch 2", nullptr, []() { webSocketToggleSwitch(1); }, false},
+  {"Switch 3", nullptr, []() { webSocketToggleSwitch(2); }, false},
+  {"Switch 4", nullptr, []() { webSocketToggleSwitch(3); }, false},
+  {"Sync Sharp A/C", nullptr, []() { webSocketSendAcState(WS_AC_SHARP); }, false},
+  {"Sync Daikin A/C", nullptr, []() { webSocketSendAcState(WS_AC_DAIKIN); }, false},
+  {"Disconnect", nullptr, webSocketDisconnect, false},
+  {"Back", nullptr, nullptr, false},  // Back button (ONLY FOR SUB-MENU)
+  {nullptr, nullptr, nullptr, false}  // Count terminator. REQUIRED FOR EVERY MENU!
+};
+
+MenuItem timerMenu[] = {
+  {"Daikin Power 30m", nullptr, []() { scheduleJob(SCHEDULE_DAIKIN_AC_POWER_TOGGLE, 0, 30 * 60); }, false},
+  {"Daikin Power 90m", nullptr, []() { scheduleJob(SCHEDULE_DAIKIN_AC_POWER_TOGGLE, 0, 90 * 60); }, false},
+  {"Sharp Off 90m", nullptr, []() { scheduleJob(SCHEDULE_SHARP_AC_OFF, 0, 90 * 60); }, false},
+  {"Switch 1 Off 1h", nullptr, []() { scheduleJob(SCHEDULE_SWITCH_OFF, 0, 60 * 60); }, false},
+  {"Switch 2 Off 1h", nullptr, []() { scheduleJob(SCHEDULE_SWITCH_OFF, 1, 60 * 60); }, false},
+  {"Switch 3 Off 1h", nullptr, []() { scheduleJob(SCHEDULE_SWITCH_OFF, 2, 60 * 60); }, false},
+  {"Switch 4 Off 1h", nullptr, []() { scheduleJob(SCHEDULE_SWITCH_OFF, 3, 60 * 60); }, false},
+  {"Cancel All", nullptr, cancelScheduledJobs, false},
+  {"Back", nullptr, nullptr, false},  // Back button (ONLY FOR SUB-MENU)
+  {nullptr, nullptr, nullptr, false}  // Count terminator. REQUIRED FOR EVERY MENU!
+};
+
+// Most used actions (see shortcuts.h), filled by buildShortcutMenu() every time the menu is opened
+const uint8_t SHORTCUT_MENU_ITEMS = 4;
+MenuItem shortcutMenu[SHORTCUT_MENU_ITEMS + 2] = {
+  {"Main Menu", nullptr, nullptr, false},  // Back button (ONLY FOR SUB-MENU)
+  {nullptr, nullptr, nullptr, false}       // Count terminator. REQUIRED FOR EVERY MENU!
+};
+char shortcutTitle[SHORTCUT_MENU_ITEMS][24];  // Titles prefixed with their menu ("Daikin Temperature")
+uint16_t shortcutMenuPath[SHORTCUT_MENU_ITEMS];
+uint8_t shortcutCount = 0;
+
 MenuItem mainMenu[] = {
+  {"Shortcuts", shortcutMenu, nullptr, false},
   {"IR Remote", irSendMenu, nullptr, false},
   {"Home Automation", homeAutomationMenu, nullptr, false},
-  {"WebSocket Client", nullptr, underDevelopment, true},
+  {"Timers", timerMenu, nullptr, false},
+  {"WebSocket Client", webSocketMenu, nullptr, false},
   {"QR Codes", nullptr, displayQr, true},
   {"Information", nullptr, displayInfo, true},
+  {"Firmware Update", nullptr, firmwareUpdateUI, true},
   {"Exit", nullptr, exitToSleep, true},
   {nullptr, nullptr, nullptr, false}  // Count terminator. REQUIRED FOR EVERY MENU!
 };
@@ -148,12 +201,9 @@ MenuItem *currentMenu = mainMenu;
 const int MAX_MENU_DEPTH = 10;            // Max levels of menu nesting
 MenuItem *menuStack[MAX_MENU_DEPTH];      // Stack to store menu history
 const char *headerStack[MAX_MENU_DEPTH];  // Stack to store current and previous display header
+int itemStack[MAX_MENU_DEPTH];            // Stack to store the selected item of each previous menu
 int menuDepth = 0;                        // Current depth in the menu stack
 
-// Track rotary encoder states
-int encoderCurrentRead = 0;
-int encoderLastRead;
-
 // Track actual index for selected/highlighted menu item
 int currentItemIndex = 0;
 
@@ -166,8 +216,10 @@ bool displayingScreen = false;
 
 // Variable to optimize power usage
 unsigned long lastActivityTime = 0;
-const unsigned long DISPLAY_TIMEOUT = 15000;     // 15 seconds
-const unsigned long ESP_SLEEP_TIMEOUT = 120000;  // 2 minutes
+const unsigned long DISPLAY_TIMEOUT = 15000;      // 15 seconds
+const unsigned long ESP_SLEEP_TIMEOUT = 120000;   // 2 minutes
+const unsigned long DISPLAY_FRAME_INTERVAL = 40;  // Minimum time (ms) between two redraws
+unsigned long lastFrameTime = 0;
 bool displayisActive = true;
 bool displayRefresh = true;
 
@@ -176,49 +228,178 @@ void drawHeader(const char *header) {
   // Display "MAIN MENU" if at top level
   if (header == 0) header = "MAIN MENU";
 
-  // Create a temporary buffer to hold the capitalized string
-  char headerUpper[strlen(header) + 1];
-  strcpy(headerUpper, header);  // Copy the input string to the buffer
+  // Fixed size buffer for the capitalized string, the header font fits 16 characters on the display
+  char headerUpper[128 / 8 + 1];
+  strlcpy(headerUpper, header, sizeof(headerUpper));  // Copy (and truncate) the input string to the buffer
 
   // Convert each character to uppercase
   for (int i = 0; headerUpper[i] != '\0'; i++) {
     headerUpper[i] = toupper(headerUpper[i]);
   }
 
-  u8g2.setFont(u8g2_font_spleen8x16_mr);                                 // Set font for header
-  u8g2.drawStr((128 - (strlen(headerUpper) * 8)) / 2, 10, headerUpper);  // Draw the capitalized header text
-  u8g2.drawHLine(0, 12, 128);                                            // Draw a horizontal line below the header
+  u8g2.setFont(u8g2_font_spleen8x16_mr);                                  // Set font for header
+  cachedDrawStr((128 - (strlen(headerUpper) * 8)) / 2, 10, headerUpper);  // Draw the capitalized header text
+  u8g2.drawHLine(0, 12, 128);                                             // Draw a horizontal line below the header
 }
 
 // Function to draw the list up to 3 menu items
 void drawMenuList() {
   for (int i = 0; i < 3; i++) {
-    int yPos = (i * 12) + 25;                                             // Calculate the y position for each menu item
-    u8g2.setFont(u8g2_font_spleen6x12_mr);                                // Set font for menu items
-    u8g2.drawStr(1, yPos, currentMenu[displayStartItemIndex + i].title);  // Draw the menu item
+    int yPos = (i * 12) + 25;                                              // Calculate the y position for each menu item
+    u8g2.setFont(u8g2_font_spleen6x12_mr);                                 // Set font for menu items
+    cachedDrawStr(1, yPos, currentMenu[displayStartItemIndex + i].title);  // Draw the menu item
+  }
+}
+
+// Menu item of a shortcut path, nullptr if the menus changed since the path was recorded
+MenuItem *resolveMenuPath(uint16_t path, const char **parentTitle) {
+  uint8_t indexes[4];  // Deepest level first
+  int levels = 0;
+  for (; path != 0 && levels < 4; path >>= 4) indexes[levels++] = (path & 0xF) - 1;
+
+  MenuItem *menu = mainMenu;
+  MenuItem *item = nullptr;
+  *parentTitle = nullptr;
+  for (int level = levels - 1; level >= 0; level--) {
+    if (indexes[level] >= getMenuItemCount(menu)) return nullptr;
+    item = &menu[indexes[level]];
+    if (level == 0) break;
+    if (item->subMenu == nullptr || item->subMenu == shortcutMenu) return nullptr;
+    *parentTitle = item->title;
+    menu = item->subMenu;
   }
+  return item;
+}
+
+// Shortcut path of the highlighted item, 0 if it cannot be encoded (too deep)
+uint16_t highlightedItemPath() {
+  if (currentMenu == shortcutMenu) return currentItemIndex < shortcutCount ? shortcutMenuPath[currentItemIndex] : 0;
+  if (menuDepth >= 4 || currentItemIndex >= 15) return 0;
+
+  uint16_t path = 0;
+  for (int depth = 0; depth < menuDepth; depth++) path = (path << 4) | (itemStack[depth] + 1);
+  return (path << 4) | (currentItemIndex + 1);
+}
+
+// Number of actions in the menu tree with this title
+int countMenuTitle(MenuItem *menu, const char *title) {
+  int count = 0;
+  for (int i = 0; menu[i].title != nullptr; i++) {
+    if (menu[i].subMenu != nullptr) count += menu[i].subMenu != shortcutMenu ? countMenuTitle(menu[i].subMenu, title) : 0;
+    else if (strcmp(menu[i].title, title) == 0) count++;
+  }
+  return count;
+}
+
+void buildShortcutMenu() {
+  uint16_t paths[SHORTCUT_MENU_ITEMS];
+  uint8_t found = topShortcuts(paths, SHORTCUT_MENU_ITEMS);
+
+  shortcutCount = 0;
+  for (uint8_t i = 0; i < found; i++) {
+    const char *parentTitle;
+    MenuItem *item = resolveMenuPath(paths[i], &parentTitle);
+    if (item == nullptr || item->action == nullptr) continue;
+
+    MenuItem &shortcut = shortcutMenu[shortcutCount];
+    shortcut = *item;  // Same action, same display behaviour; unique titles (switch labels) stay live
+    if (parentTitle != nullptr && countMenuTitle(mainMenu, item->title) > 1) {  // "Temperature" -> "Daikin Temperature"
+      snprintf(shortcutTitle[shortcutCount], sizeof(shortcutTitle[0]), "%.*s %s", (int)strcspn(parentTitle, " "), parentTitle, item->title);
+      shortcut.title = shortcutTitle[shortcutCount];
+    }
+    shortcutMenuPath[shortcutCount++] = paths[i];
+  }
+  shortcutMenu[shortcutCount] = {"Main Menu", nullptr, nullptr, false};
+  shortcutMenu[shortcutCount + 1] = {nullptr, nullptr, nullptr, false};
+}
+
+// Top-level section (mainMenu sub-menu) of a shortcut
+MenuItem *shortcutSection(int index) {
+  if (index >= shortcutCount) return nullptr;
+  uint16_t path = shortcutMenuPath[index];
+  while (path > 0xF) path >>= 4;
+  return mainMenu[path - 1].subMenu;
+}
+
+bool webSocketWarm = false;  // Connected for the first shortcut only, not used yet
+
+// Start the radios when their menu or status screen is entered, so drawing a frame never does.
+// ESP-NOW listens for pushed switch states only while the Home Automation menu is open, and stays
+// on for a firmware update until it is done, whatever screen is open.
+// The shortcuts menu speculatively starts the radio of its first shortcut, so that command goes out
+// without waiting for Wi-Fi (the IR emitters are always ready). A connection started that way is
+// dropped again when the shortcuts are left without using it.
+// Called on every menu change and when a screen is opened or closed.
+void updateMenuSubscriptions() {
+  // A screen opened from the shortcuts belongs to the menu its shortcut was copied from
+  bool shortcutScreen = currentMenu == shortcutMenu && displayingScreen;
+  MenuItem *section = shortcutScreen ? shortcutSection(currentItemIndex) : currentMenu;
+  MenuItem *warmSection = currentMenu == shortcutMenu ? shortcutSection(0) : nullptr;
+  void (*screen)() = displayingScreen ? currentMenu[currentItemIndex].action : nullptr;
+
+  if (section == homeAutomationMenu || warmSection == homeAutomationMenu || screen == firmwareUpdateUI || deltaOtaBusy()) espNowSubscribe();
+  else espNowUnsubscribe();
+
+  if (section == webSocketMenu) webSocketWarm = false;  // Entered or taken: the connection is wanted now
+  else if (warmSection == webSocketMenu && !webSocketActive()) webSocketWarm = true;
+
+  if (section == webSocketMenu || warmSection == webSocketMenu) webSocketConnect();
+  else if (webSocketWarm) {
+    webSocketWarm = false;
+    webSocketDisconnect();
+  }
+}
+
+// Start on the shortcuts when there are any, with the main menu one "Back" away
+void openShortcutMenu() {
+  buildShortcutMenu();
+  if (shortcutCount == 0) return;
+
+  headerStack[0] = mainMenu[0].title;
+  itemStack[0] = 0;
+  menuStack[0] = mainMenu;
+  menuDepth = 1;
+  currentMenu = shortcutMenu;
+  updateMenuSubscriptions();
+}
+
+// Count the highlighted action for the shortcuts and the time to the first command
+void recordMenuCommand() {
+  recordFirstCommand();
+  if (currentMenu == shortcutMenu && shortcutSection(currentItemIndex) == webSocketMenu) webSocketWarm = false;  // Keep the connection it uses
+  if (currentMenu[currentItemIndex].action != exitToSleep) recordShortcutUse(highlightedItemPath());
 }
 
 // clang-format off
 // Handle "select" button press for menu navigation
 void selectHighlightedMenu() {
   if (selectButton.pressed()) {
+    encoderInputClear();  // Turns made before the press belong to the previous screen
+
     if (currentMenu[currentItemIndex].action != nullptr) {  // Execute action if defined
+      if (!displayingScreen) recordMenuCommand();
+      else if (currentMenu[currentItemIndex].action == firmwareUpdateUI && deltaOtaAccept()) return;  // Confirms an offered update, the screen stays
 
       // Check if the action requires display update
-      if (currentMenu[currentItemIndex].requireUpdateDisplay) displayingScreen = !displayingScreen;  // function require display to be updated
-      else currentMenu[currentItemIndex].action();                                                   // Only execute code without requiring to update the display
+      if (currentMenu[currentItemIndex].requireUpdateDisplay) {  // function require display to be updated
+        displayingScreen = !displayingScreen;
+        updateMenuSubscriptions();                               // Status screens start their radio when opened
+      }
+      else currentMenu[currentItemIndex].action();               // Only execute code without requiring to update the display
     }
 
     else if (currentMenu[currentItemIndex].subMenu != nullptr && menuDepth < MAX_MENU_DEPTH) {  // Enter sub-menu if defined
       headerStack[menuDepth] = currentMenu[currentItemIndex].title;                             // Push current menu title onto the stack to update the header
       // Push current menu onto the stack before entering submenu
+      itemStack[menuDepth] = currentItemIndex;
       menuStack[menuDepth++] = currentMenu;
       currentMenu = currentMenu[currentItemIndex].subMenu;
+      if (currentMenu == shortcutMenu) buildShortcutMenu();
       // Reset index for display and selection
       displayStartItemIndex = 0;
       displaySelectedItemIndex = 0;
       currentItemIndex = 0;
+      updateMenuSubscriptions();
     }
 
     else if (currentItemIndex == (getMenuItemCount(currentMenu) - 1) && menuDepth > 0) {  // Go back if select 'back' option in sub-menu
@@ -228,6 +409,7 @@ void selectHighlightedMenu() {
       displayStartItemIndex = 0;
       displaySelectedItemIndex = 0;
       currentItemIndex = 0;
+      updateMenuSubscriptions();
     }
   }
 }
@@ -241,11 +423,12 @@ void highlightSelectedItem() {
 }
 
 void encoderHandler() {
-  int totalMenuItems = getMenuItemCount(currentMenu);                            // Get total current menu count
-  const int visibleItemsCount = min(totalMenuItems - displayStartItemIndex, 3);  // Limit to the number of items being displayed
-  
-  // Handle encoder rotation for menu navigation
-  if (encoderCurrentRead > encoderLastRead) {
+  int totalMenuItems = getMenuItemCount(currentMenu);  // Get total current menu count
+  int steps = encoderTakeSteps(ENCODER_MENU);          // Accumulated (accelerated) encoder steps
+
+  // Handle encoder rotation for menu navigation, one item per step
+  for (; steps > 0; steps--) {
+    const int visibleItemsCount = min(totalMenuItems - displayStartItemIndex, 3);  // Limit to the number of items being displayed
     currentItemIndex++;
 
     if (currentItemIndex > totalMenuItems - 1) currentItemIndex = totalMenuItems - 1;  // Prevent overflow
@@ -254,7 +437,7 @@ void encoderHandler() {
     else if (displayStartItemIndex + 3 < totalMenuItems) displayStartItemIndex++;      // Scroll down the list
   }
 
-  if (encoderLastRead > encoderCurrentRead) {
+  for (; steps < 0; steps++) {
     currentItemIndex--;
 
     if (currentItemIndex < 0) currentItemIndex = 0;  // Prevent overflow
@@ -267,36 +450,51 @@ void encoderHandler() {
 // clang-format on
 // Function to draw the entire menu screen
 void drawMenu() {
+  unsigned long renderStart = micros();
   u8g2.clearBuffer();     // Clear the display buffer
   u8g2.setFontMode(1);    // Set font mode
   u8g2.setBitmapMode(1);  // Set bitmap mode
+  u8g2.setDrawColor(1);   // The highlight of the previous frame leaves it at 2 (XOR)
 
   if (displayingScreen) {  // Check if function require to update the display
     currentMenu[currentItemIndex].action();
   }
 
   else {
-    drawHeader(headerStack[menuDepth - 1]);
+    drawHeader(menuDepth > 0 ? headerStack[menuDepth - 1] : nullptr);
     drawMenuList();
     highlightSelectedItem();
 
     // Footer with version info
     u8g2.drawHLine(0, 54, 128);                              // Draw a horizontal line at the footer
-    u8g2.setFont(u8g2_font_minuteconsole_mr);                // Set font for footer
-    u8g2.drawStr(128 - (strlen(version) * 5), 63, version);  // Draw the version information at the bottom right
+    u8g2.setFont(u8g2_font_minuteconsole_mr);                 // Set font for footer
+    cachedDrawStr(128 - (strlen(version) * 5), 63, version);  // Draw the version information at the bottom right
   }
+  metricsFrameRendered(micros() - renderStart);
   u8g2.sendBuffer();  // Send the buffer to the display
 }
 
 void setup() {
-  Serial.begin(115200);  // Initialize serial communication
+  Serial.setRxBufferSize(1024);  // Room for pipelined serial commands between two loop() runs
+  Serial.begin(115200);          // Initialize serial communication
 #if DEBUG_ENABLE
   Serial.println("Debug mode: ENABLE");
 #endif
+  loadSettings();        // Restore AC settings and switch states from the flash journal
+  updateSwitchLabels();  // Restored states equal to the defaults do not count as a change
+
+  // Woken up by the scheduler: run the due jobs headless and go back to sleep (never returns)
+  if (isSchedulerWakeup()) runHeadlessWakeup();
+
   u8g2.begin();                       // Initialize the OLED display
   pinMode(STATUS_INDICATOR, OUTPUT);  // Initialize built-in LED
   initIrGeneral();                    // Initialize the IR LED for general electrical appliances
   initIrAirCond();                    // Initialize the IR LED for Air-Conditioner
+#if DEBUG_ENABLE && DEBUG_IR_VERIFY
+  runIrVerification();  // Report on Serial, see ir_verify.h
+#endif
+  deltaOtaInit();                     // Before the radio starts and before the heap guard
+  openShortcutMenu();                 // First screen: the most used actions, with their radio warmed up
   dataUpdateOnStartup();              // Update Home Automation Data
 
   // Configure the rotary encoder
@@ -308,35 +506,47 @@ void setup() {
   selectButton.interval(5);           // Set debounce interval
   selectButton.setPressedState(LOW);  // Set pressed state for active-low logic
 
-  // Enable EXT0 wake-up on select button (rising edge)
-  esp_sleep_enable_ext0_wakeup((gpio_num_t)SELECT_BUTTON, 0);
+  armHeapGuard();  // From here on every heap allocation is reported (heap_guard build)
 }
 
 void loop() {
-  // Obtain encoder read value
-  encoderCurrentRead = rotaryEncoder.getCount();
+  metricsLoopTick();
+  heapGuardLoop();
+
+  // Obtain encoder read value; the steps are collected until the menu or the A/C screen takes them
+  bool encoderTurned = encoderInputUpdate(rotaryEncoder.getCount(), micros());
+#if DEBUG_ENABLE && DEBUG_ENCODER
+  if (encoderTurned) {  // Rotation trace, one line per change: paste the lines into sim/scenarios/traces to replay them
+    static unsigned long lastChangeUs = micros();
+    static int64_t lastCount = 0;
+    Serial.printf("%.1f %+d  # encoder trace\n", (micros() - lastChangeUs) / 1000.0, (int)(rotaryEncoder.getCount() - lastCount));
+    lastChangeUs = micros();
+    lastCount = rotaryEncoder.getCount();
+  }
+#endif
 
   // Update the button states
   selectButton.update();
 
-  // Draw the menu on the OLED display
-  if (displayRefresh) {
+  // Draw the menu on the OLED display, at most once per frame however fast the encoder turns
+  if (displayRefresh && millis() - lastFrameTime >= DISPLAY_FRAME_INTERVAL) {
+    lastFrameTime = millis();
     drawMenu();
-    if ((millis() - lastActivityTime) > 1000) {
+    if ((millis() - lastActivityTime) > 1000 && (irSignalSent || !displayingScreen)) {  // A/C screens send the setting from drawMenu()
       displayRefresh = false;
     }
   }
 
   // Monitor user activity and manage display wake-up & timeout to save power
   // Debugging messages are included for better visibility
-  if (encoderCurrentRead != encoderLastRead || selectButton.pressed()) {
+  if (encoderTurned || selectButton.pressed()) {
     lastActivityTime = millis();
     displayRefresh = true;
     selectHighlightedMenu();
     if (!displayingScreen) encoderHandler();
 #if DEBUG_ENABLE && DEBUG_ENCODER
-    Serial.println("Current encoder value: " + String(encoderCurrentRead));
-    Serial.println("Previous encoder value: " + String(encoderLastRead));
+    Serial.printf("Current encoder value: %lld\n", (long long)rotaryEncoder.getCount());
+    Serial.printf("Encoder speed: %u counts/s\n", encoderVelocity());
     Serial.println();
 #endif
 #if DEBUG_ENABLE && DEBUG_MENU_ITEM
@@ -363,8 +573,32 @@ void loop() {
 #endif
   }
 
-  if (!displayisActive && (millis() - lastActivityTime > ESP_SLEEP_TIMEOUT)) esp_deep_sleep_start();
+  // Scripted commands on Serial count as activity, so the remote stays awake while a host drives it
+  if (serialCommandLoop()) {
+    lastActivityTime = millis();
+    displayRefresh = true;
+  }
+
+  // Keep the WebSocket connection alive and process responses
+  webSocketLoop();
+
+  // Send the IR frames queued by serial commands, one poll per loop
+  irPoll();
+
+  // Apply switch states pushed by the receiver; redraw only when something changed
+  if (espNowPoll()) displayRefresh = true;
+
+  // Receive or seed a delta firmware update while the radio is listening; a transfer runs to its end
+  // (reboot, or abort without chunks) even after its screen was closed
+  bool otaBusy = deltaOtaBusy();
+  if (espNowListening() || otaBusy) deltaOtaLoop();
+  if (otaBusy && !deltaOtaBusy()) updateMenuSubscriptions();  // Transfer over: release the radio
+
+  // Execute scheduled jobs that fall due while the remote is awake
+  runDueJobs();
+
+  // Write batched setting changes to flash once the user stops turning the encoder
+  flushSettingsIfIdle();
 
-  // Update the rotary encoder values for tracking
-  encoderLastRead = encoderCurrentRead;
+  if (!displayisActive && (millis() - lastActivityTime > ESP_SLEEP_TIMEOUT) && !deltaOtaBusy()) enterDeepSleep();
 }
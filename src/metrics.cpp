@@ -0,0 +1,54 @@
+#include "metrics.h"
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+#include "heap_guard.h"
+#include "shortcuts.h"
+
+// Tasks whose stack high-water mark is reported (missing ones, e.g. wifi while the radio is off, are skipped)
+const char *const METRICS_TASKS[] = {"loopTask", "esp_timer", "wifi", "sys_evt", "tiT"};
+
+Metrics metrics;
+unsigned long lastLoopTick = 0;
+
+void metricsLoopTick() {
+  unsigned long now = micros();
+  if (metrics.loopCount > 0) metrics.loopMaxUs = max(metrics.loopMaxUs, (uint32_t)(now - lastLoopTick));
+  lastLoopTick = now;
+  metrics.loopCount++;
+}
+
+void metricsFrameRendered(uint32_t renderUs) {
+  metrics.frameCount++;
+  metrics.frameMaxUs = max(metrics.frameMaxUs, renderUs);
+  metrics.frameTotalUs += renderUs;
+}
+
+void formatMetrics(char *buffer, size_t size) {
+  snprintf(buffer, size, "uptime=%lu loops=%lu loopMaxUs=%lu irFrames=%lu serialRx=%lu serialOk=%lu serialErr=%lu serialDropped=%lu serialQueuePeak=%lu",
+           millis() / 1000, (unsigned long)metrics.loopCount, (unsigned long)metrics.loopMaxUs, (unsigned long)metrics.irFrames,
+           (unsigned long)metrics.serialReceived, (unsigned long)metrics.serialCompleted, (unsigned long)metrics.serialFailed,
+           (unsigned long)metrics.serialDropped, (unsigned long)metrics.serialQueuePeak);
+
+  size_t length = strlen(buffer);
+  length += snprintf(buffer + length, size - length, " heapFree=%lu heapMin=%lu heapBlock=%lu heapAllocs=%lu",
+                     (unsigned long)heap_caps_get_free_size(MALLOC_CAP_8BIT), (unsigned long)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT),
+                     (unsigned long)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT), (unsigned long)heapAllocationsAfterSetup());
+
+  if (length < size) {
+    length += snprintf(buffer + length, size - length, " frames=%lu frameAvgUs=%lu frameMaxUs=%lu cacheHits=%lu cacheMisses=%lu",
+                       (unsigned long)metrics.frameCount, (unsigned long)(metrics.frameCount > 0 ? metrics.frameTotalUs / metrics.frameCount : 0),
+                       (unsigned long)metrics.frameMaxUs, (unsigned long)metrics.renderCacheHits, (unsigned long)metrics.renderCacheMisses);
+  }
+  if (length < size) {
+    length += snprintf(buffer + length, size - length, " firstCommandMs=%lu wakeSamples=%u", (unsigned long)firstCommandMedianMs(),
+                       firstCommandSamples());
+  }
+
+  for (const char *name : METRICS_TASKS) {
+    if (length >= size) break;
+    TaskHandle_t task = xTaskGetHandle(name);
+    if (task != nullptr) length += snprintf(buffer + length, size - length, " stack.%s=%lu", name, (unsigned long)uxTaskGetStackHighWaterMark(task));
+  }
+}
@@ -0,0 +1,33 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Runtime counters, queried with the "metrics" serial command.
+// formatMetrics() also reports the heap (free, minimum ever free, largest block, allocations after
+// setup in the heap_guard build), the stack high-water mark (bytes never used) of the main tasks and
+// the median time from wake-up to the first menu command (firstCommandMs, see shortcuts.h).
+struct Metrics {
+  uint32_t loopCount;        // loop() iterations since boot
+  uint32_t loopMaxUs;        // Longest loop() iteration
+  uint32_t irFrames;         // IR frames transmitted
+  uint32_t serialReceived;   // Serial commands queued
+  uint32_t serialCompleted;  // Serial commands answered with OK
+  uint32_t serialFailed;     // Serial commands answered with ERR (including dropped ones)
+  uint32_t serialDropped;    // Serial commands rejected because the queue was full
+  uint32_t serialQueuePeak;  // Highest number of queued serial commands
+  uint32_t frameCount;       // Menu frames drawn
+  uint32_t frameMaxUs;       // Longest frame render, without the transfer to the display
+  uint32_t frameTotalUs;     // Render time of all frames (frameAvgUs = frameTotalUs / frameCount)
+  uint32_t renderCacheHits;    // Strings copied from the render cache
+  uint32_t renderCacheMisses;  // Strings rendered from the font
+};
+
+extern Metrics metrics;
+
+void metricsLoopTick();  // Put this at the top of the void loop in the main.cpp
+void metricsFrameRendered(uint32_t renderUs);
+void formatMetrics(char *buffer, size_t size);  // key=value pairs on one line
+
+#endif
@@ -0,0 +1,126 @@
+#include "render_cache.h"
+
+#include "metrics.h"
+
+RenderCacheHook renderCacheHook = nullptr;
+
+#if RENDER_CACHE_ENABLE
+
+const uint8_t RENDER_CACHE_SLOTS = 24;            // Header, 3 menu rows, footer and the A/C screen labels fit with room to scroll
+const uint16_t RENDER_CACHE_SLOT_BYTES = 256;     // 128 columns x 2 pages (8 rows each), or narrower and taller
+const uint8_t RENDER_CACHE_TEXT_LENGTH = 24;      // Longer strings are drawn uncached
+
+struct RenderCacheSlot {
+  const uint8_t *font;  // nullptr = free slot
+  char text[RENDER_CACHE_TEXT_LENGTH];
+  uint32_t lastUsed;
+  uint8_t width;     // Columns, including one blank column on each side
+  uint8_t pages;     // Rows / 8
+  uint8_t baseline;  // Rows from the top of the bitmap to the baseline
+  uint8_t bitmap[RENDER_CACHE_SLOT_BYTES];  // Same layout as the display buffer: one byte = 8 rows of a column, LSB on top
+};
+
+RenderCacheSlot renderCache[RENDER_CACHE_SLOTS];
+uint8_t renderScratch[RENDER_CACHE_SLOT_BYTES];  // Display buffer bytes set aside while a slot is rendered
+uint32_t renderCacheClock = 0;
+
+// Render the string into the top left corner of the display buffer and keep a copy of the pixels
+bool renderSlot(RenderCacheSlot &slot, const uint8_t *font, const char *text) {
+  const u8g2_t *state = u8g2.getU8g2();
+  uint8_t height = state->font_info.max_char_height;
+  int8_t baseline = height + state->font_info.y_offset;  // y_offset: lowest row of the glyphs, relative to the baseline
+  uint16_t width = u8g2.getStrWidth(text) + 2;
+  uint8_t pages = (height + 7) / 8;
+  const uint16_t bufferWidth = u8g2.getBufferTileWidth() * 8;
+  if (width > bufferWidth || width * pages > RENDER_CACHE_SLOT_BYTES || baseline < 0) return false;
+
+  uint8_t *buffer = u8g2.getBufferPtr();
+  for (uint8_t page = 0; page < pages; page++) {
+    memcpy(renderScratch + page * width, buffer + page * bufferWidth, width);
+    memset(buffer + page * bufferWidth, 0, width);
+  }
+
+  uint8_t drawColor = u8g2.getDrawColor();
+  u8g2.setDrawColor(1);
+  u8g2.drawStr(1, baseline, text);
+  u8g2.setDrawColor(drawColor);
+
+  for (uint8_t page = 0; page < pages; page++) {
+    memcpy(slot.bitmap + page * width, buffer + page * bufferWidth, width);
+    memcpy(buffer + page * bufferWidth, renderScratch + page * width, width);
+  }
+
+  slot.font = font;
+  strlcpy(slot.text, text, sizeof(slot.text));
+  slot.width = width;
+  slot.pages = pages;
+  slot.baseline = baseline;
+  return true;
+}
+
+// Combine one byte of the bitmap with the display buffer like u8g2 draws a glyph pixel
+inline void blitByte(uint8_t &target, uint8_t bits, uint8_t drawColor) {
+  if (drawColor == 0) target &= ~bits;
+  else if (drawColor == 1) target |= bits;
+  else target ^= bits;
+}
+
+// Copy the bitmap to the display buffer; the top row can be anywhere, so each byte is split over two pages
+void blitSlot(const RenderCacheSlot &slot, int x, int y) {
+  uint8_t *buffer = u8g2.getBufferPtr();
+  const int bufferWidth = u8g2.getBufferTileWidth() * 8;
+  const int bufferPages = u8g2.getBufferTileHeight();
+  const uint8_t drawColor = u8g2.getDrawColor();
+
+  int top = y - slot.baseline + 64;  // Kept positive for the division, the 8 pages added are removed below
+  int firstPage = top / 8 - 8;
+  uint8_t shift = top % 8;
+  x -= 1;  // Blank column on the left
+
+  for (uint8_t page = 0; page < slot.pages; page++) {
+    int upper = firstPage + page;
+    int lower = upper + 1;
+    const uint8_t *source = slot.bitmap + page * slot.width;
+
+    for (int column = 0; column < slot.width; column++) {
+      int targetX = x + column;
+      if (targetX < 0 || targetX >= bufferWidth || source[column] == 0) continue;
+
+      if (upper >= 0 && upper < bufferPages) blitByte(buffer[upper * bufferWidth + targetX], source[column] << shift, drawColor);
+      if (shift > 0 && lower >= 0 && lower < bufferPages) blitByte(buffer[lower * bufferWidth + targetX], source[column] >> (8 - shift), drawColor);
+    }
+  }
+}
+
+void cachedDrawStr(int x, int y, const char *text) {
+  const uint8_t *font = u8g2.getU8g2()->font;
+  RenderCacheSlot *victim = &renderCache[0];
+  renderCacheClock++;
+  if (renderCacheHook != nullptr) renderCacheHook(x, y, text);
+
+  for (RenderCacheSlot &slot : renderCache) {
+    if (slot.font == font && strcmp(slot.text, text) == 0) {
+      slot.lastUsed = renderCacheClock;
+      metrics.renderCacheHits++;
+      blitSlot(slot, x, y);
+      return;
+    }
+    if (victim->font != nullptr && (slot.font == nullptr || slot.lastUsed < victim->lastUsed)) victim = &slot;
+  }
+
+  metrics.renderCacheMisses++;
+  if (strlen(text) >= RENDER_CACHE_TEXT_LENGTH || !renderSlot(*victim, font, text)) {
+    u8g2.drawStr(x, y, text);
+    return;
+  }
+  victim->lastUsed = renderCacheClock;
+  blitSlot(*victim, x, y);
+}
+
+#else
+
+void cachedDrawStr(int x, int y, const char *text) {
+  u8g2.drawStr(x, y, text);
+}
+
+#endif
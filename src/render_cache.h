@@ -0,0 +1,27 @@
+#ifndef RENDER_CACHE_H
+#define RENDER_CACHE_H
+
+#include <U8g2lib.h>
+
+// Cache of pre-rendered strings for the menu header, menu rows and A/C labels.
+// The first time a string is drawn with a font its glyphs are decoded into a bitmap slot, after
+// that cachedDrawStr() only copies the bitmap into the display buffer. Slots live in a fixed
+// arena and the least recently used one is reused when the arena is full.
+// Same result as u8g2.drawStr() in transparent font mode (setFontMode(1), set by drawMenu()).
+// Set RENDER_CACHE_ENABLE to 0 to draw every string with u8g2.drawStr() (compare frameAvgUs
+// in the "metrics" serial command, or the sim and sim_nocache environments on the host).
+
+#ifndef RENDER_CACHE_ENABLE
+#define RENDER_CACHE_ENABLE 1
+#endif
+
+extern U8G2_SH1106_128X64_NONAME_F_HW_I2C u8g2;
+
+void cachedDrawStr(int x, int y, const char *text);  // Drop-in for u8g2.drawStr() with the current font and draw color
+
+// Called with every string cachedDrawStr() draws, before it is drawn. Cache hits never reach
+// u8g2.drawStr(), the simulator uses it to keep its list of the strings on the screen.
+typedef void (*RenderCacheHook)(int x, int y, const char *text);
+extern RenderCacheHook renderCacheHook;
+
+#endif
@@ -0,0 +1,102 @@
+#include "scheduler.h"
+
+#include <Arduino.h>
+#include <time.h>
+
+#include "ESPNOW.h"
+#include "ir_aircond.h"
+#include "utils.h"
+
+// A pending job. dueTime is in seconds of the RTC backed system clock,
+// which keeps counting through deep sleep.
+struct ScheduledJob {
+  uint32_t dueTime;
+  ScheduledAction action;
+  uint8_t arg;
+};
+
+// Job queue kept sorted by due time (earliest first) so the next wake-up is always jobQueue[0].
+// RTC_DATA_ATTR keeps the queue alive through deep sleep.
+RTC_DATA_ATTR ScheduledJob jobQueue[MAX_SCHEDULED_JOBS];
+RTC_DATA_ATTR uint8_t jobCount = 0;
+
+uint32_t schedulerNow() {
+  return (uint32_t)time(nullptr);
+}
+
+bool scheduleJob(ScheduledAction action, uint8_t arg, uint32_t delaySeconds) {
+  if (jobCount >= MAX_SCHEDULED_JOBS) return false;
+
+  ScheduledJob job = {schedulerNow() + delaySeconds, action, arg};
+
+  // Insertion sort: jobs with equal due time keep the order they were scheduled in
+  int i = jobCount;
+  while (i > 0 && jobQueue[i - 1].dueTime > job.dueTime) {
+    jobQueue[i] = jobQueue[i - 1];
+    i--;
+  }
+  jobQueue[i] = job;
+  jobCount++;
+  return true;
+}
+
+void cancelScheduledJobs() {
+  jobCount = 0;
+}
+
+uint8_t scheduledJobCount() {
+  return jobCount;
+}
+
+void executeJob(const ScheduledJob &job) {
+  switch (job.action) {
+    case SCHEDULE_SHARP_AC_OFF:
+      sharpAcPowerOff();
+      break;
+    case SCHEDULE_DAIKIN_AC_POWER_TOGGLE:
+      daikinAcPowerToggle();
+      break;
+    case SCHEDULE_SWITCH_OFF:
+      setSwitchState(job.arg, false);
+      break;
+    case SCHEDULE_SWITCH_ON:
+      setSwitchState(job.arg, true);
+      break;
+  }
+}
+
+// Pop and execute every job that is due
+void runDueJobs() {
+  uint32_t now = schedulerNow();
+
+  while (jobCount > 0 && jobQueue[0].dueTime <= now) {
+    ScheduledJob job = jobQueue[0];
+
+    // Remove the job before executing it so a reset during execution does not repeat it forever
+    for (int i = 1; i < jobCount; i++) jobQueue[i - 1] = jobQueue[i];
+    jobCount--;
+
+    executeJob(job);
+  }
+}
+
+// Enable the timer wake-up for the earliest pending job
+void armSchedulerWakeup() {
+  if (jobCount == 0) return;
+
+  uint32_t now = schedulerNow();
+  uint32_t delaySeconds = jobQueue[0].dueTime > now ? jobQueue[0].dueTime - now : 0;
+
+  esp_sleep_enable_timer_wakeup((uint64_t)delaySeconds * 1000000ULL + 1000ULL);  // Add 1 ms so the job is due on wake
+}
+
+bool isSchedulerWakeup() {
+  return esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER;
+}
+
+// Headless path: no display, no encoder and no Home Automation data pull
+void runHeadlessWakeup() {
+  initIrAirCond();
+  runDueJobs();
+  enterDeepSleep();
+}
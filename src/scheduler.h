@@ -0,0 +1,25 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+// Commands that can be deferred and executed later, even from a deep-sleep timer wake-up
+enum ScheduledAction : uint8_t {
+  SCHEDULE_SHARP_AC_OFF,
+  SCHEDULE_DAIKIN_AC_POWER_TOGGLE,
+  SCHEDULE_SWITCH_OFF,  // arg = switch index (0-3)
+  SCHEDULE_SWITCH_ON,   // arg = switch index (0-3)
+};
+
+const uint8_t MAX_SCHEDULED_JOBS = 8;  // Pending jobs kept in RTC memory
+
+bool scheduleJob(ScheduledAction action, uint8_t arg, uint32_t delaySeconds);  // Returns false when the queue is full
+void cancelScheduledJobs();
+uint8_t scheduledJobCount();
+void runDueJobs();  // Call from loop() to execute jobs that fall due while awake
+
+void armSchedulerWakeup();  // Put this right before esp_deep_sleep_start()
+bool isSchedulerWakeup();
+void runHeadlessWakeup();  // Execute due jobs without UI and go straight back to sleep
+
+#endif
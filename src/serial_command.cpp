@@ -0,0 +1,339 @@
+#include "serial_command.h"
+
+#include <Arduino.h>
+
+#include "ESPNOW.h"
+#include "ir_aircond.h"
+#include "ir_emitter.h"
+#include "ir_general.h"
+#include "metrics.h"
+
+const unsigned long SERIAL_EXECUTE_BUDGET = 5;  // Duration (ms) of queued commands executed per loop()
+const size_t SERIAL_REPLY_LENGTH = 640;
+const uint8_t SERIAL_ID_LENGTH = 16;
+
+// Named IR codes for the "ir" command
+struct IrCodeName {
+  const char *name;
+  void (*send)();
+};
+
+const IrCodeName irCodes[] = {
+  {"lg.power", [] { sendLGTV(tvLGPowerToggle); }},
+  {"lg.volup", [] { sendLGTV(tvLGVolumeUp); }},
+  {"lg.voldown", [] { sendLGTV(tvLGVolumeDown); }},
+  {"lg.mute", [] { sendLGTV(tvLGVolumeMute); }},
+  {"astro.power", [] { sendAstroTv(tvAstroPowerToggle); }},
+  {"astro.back", [] { sendAstroTv(tvAstroButtonBack); }},
+  {"astro.chup", [] { sendAstroTv(tvAstroChannelUp); }},
+  {"astro.chdown", [] { sendAstroTv(tvAstroChannelDown); }},
+  {"astro.0", [] { sendAstroTv(tvAstroButtonZero); }},
+  {"astro.1", [] { sendAstroTv(tvAstroButtonOne); }},
+  {"astro.2", [] { sendAstroTv(tvAstroButtonTwo); }},
+  {"astro.3", [] { sendAstroTv(tvAstroButtonThree); }},
+  {"astro.4", [] { sendAstroTv(tvAstroButtonFour); }},
+  {"astro.5", [] { sendAstroTv(tvAstroButtonFive); }},
+  {"astro.6", [] { sendAstroTv(tvAstroButtonSix); }},
+  {"astro.7", [] { sendAstroTv(tvAstroButtonSeven); }},
+  {"astro.8", [] { sendAstroTv(tvAstroButtonEight); }},
+  {"astro.9", [] { sendAstroTv(tvAstroButtonNine); }},
+  {"deka.off", [] { sendDekaFan(fanDekaPowerOff); }},
+  {"deka.1", [] { sendDekaFan(fanDekaSpeedOne); }},
+  {"deka.2", [] { sendDekaFan(fanDekaSpeedTwo); }},
+  {"deka.3", [] { sendDekaFan(fanDekaSpeed0Three); }},
+  {"fft.off", [] { sendFFTFan(fanFFTPowerOff); }},
+  {"fft.1", [] { sendFFTFan(fanFFTSpeedOne); }},
+  {"fft.2", [] { sendFFTFan(fanFFTSpeedTwo); }},
+  {"fft.3", [] { sendFFTFan(fanFFTSpeedThree); }},
+  {"fft.4", [] { sendFFTFan(fanFFTSpeedFour); }},
+  {"sharp.power", sharpAcPowerToggle},
+  {"daikin.power", daikinAcPowerToggle},
+  {"all.off", irPowerOffAll},
+};
+
+// REPLACE WITH YOUR SCENES: every step is a command line without id
+const char *const sceneAllOff[] = {"ir all.off", "switch 1 off", "switch 2 off", "switch 3 off", "switch 4 off", nullptr};
+const char *const sceneSleep[] = {"ac sharp on 26 cool min on", "ir deka.1", "switch 1 off", "switch 2 off", nullptr};
+
+struct Scene {
+  const char *name;
+  const char *const *steps;
+};
+
+const Scene scenes[] = {
+  {"alloff", sceneAllOff},
+  {"sleep", sceneSleep},
+};
+
+char serialInput[SERIAL_LINE_LENGTH];  // Line being received
+uint8_t serialInputLength = 0;
+bool serialInputOverflow = false;
+
+char serialQueue[SERIAL_QUEUE_SIZE][SERIAL_LINE_LENGTH];  // Complete lines waiting for execution
+uint8_t serialQueueHead = 0;
+uint8_t serialQueueCount = 0;
+
+// Response of the command whose IR frames or switch send are still going out
+bool serialReplyPending = false;
+bool serialPendingOk = false;
+char serialPendingId[SERIAL_ID_LENGTH];
+char serialPendingReply[SERIAL_REPLY_LENGTH];
+
+void serialReply(const char *id, bool ok, const char *text) {
+  Serial.printf("%s %s%s%s\n", id, ok ? "OK" : "ERR", text[0] ? " " : "", text);
+  if (ok) metrics.serialCompleted++;
+  else metrics.serialFailed++;
+}
+
+/*================================ ARGUMENT PARSING ================================*/
+int findLabel(const char *value, const char *const *labels, int count) {
+  if (value == nullptr) return -1;
+  for (int i = 0; i < count; i++) {
+    if (strcasecmp(value, labels[i]) == 0) return i;
+  }
+  return -1;
+}
+
+bool parseOnOff(const char *value, bool &state) {
+  if (value == nullptr) return false;
+  if (strcmp(value, "on") == 0) state = true;
+  else if (strcmp(value, "off") == 0) state = false;
+  else return false;
+  return true;
+}
+
+bool parseTemp(const char *value, uint8_t &temp) {
+  if (value == nullptr) return false;
+  int parsed = atoi(value);
+  if (parsed < 16 || parsed > 30) return false;
+  temp = parsed;
+  return true;
+}
+
+/*==================================== COMMANDS ====================================*/
+bool commandError(char *reply, size_t replySize, const char *reason) {
+  strlcpy(reply, reason, replySize);
+  return false;
+}
+
+bool executeCommand(char *line, char *reply, size_t replySize);
+
+bool commandIr(char *name, char *reply, size_t replySize) {
+  if (name == nullptr) return commandError(reply, replySize, "missing code name");
+  for (const IrCodeName &code : irCodes) {
+    if (strcmp(name, code.name) == 0) {
+      code.send();
+      return true;
+    }
+  }
+  snprintf(reply, replySize, "unknown code %s", name);
+  return false;
+}
+
+// ac sharp off | ac sharp on <temp> <mode> <fan> <swing> | ac daikin <temp> <mode> <fan> <swing> [toggle]
+bool commandAc(char *unit, char **save, char *reply, size_t replySize) {
+  if (unit != nullptr && strcmp(unit, "sharp") == 0) {
+    bool power;
+    if (!parseOnOff(strtok_r(nullptr, " ", save), power)) return commandError(reply, replySize, "expected on|off");
+    if (!power) {
+      sharpAcPowerOff();
+      return true;
+    }
+
+    uint8_t temp;
+    bool swing;
+    if (!parseTemp(strtok_r(nullptr, " ", save), temp)) return commandError(reply, replySize, "temp 16-30");
+    int modeIndex = findLabel(strtok_r(nullptr, " ", save), sharpSetModeLabel, 3);
+    int fanIndex = findLabel(strtok_r(nullptr, " ", save), sharpSetFanLabel, 4);
+    if (modeIndex < 0) return commandError(reply, replySize, "mode auto|dry|cool");
+    if (fanIndex < 0) return commandError(reply, replySize, "fan auto|min|med|max");
+    if (!parseOnOff(strtok_r(nullptr, " ", save), swing)) return commandError(reply, replySize, "swing on|off");
+
+    sharpAcApplyState(temp, modeIndex, fanIndex, swing);
+    return true;
+  }
+
+  if (unit != nullptr && strcmp(unit, "daikin") == 0) {
+    uint8_t temp;
+    bool swing;
+    if (!parseTemp(strtok_r(nullptr, " ", save), temp)) return commandError(reply, replySize, "temp 16-30");
+    int modeIndex = findLabel(strtok_r(nullptr, " ", save), daikinSetModeLabel, 3);
+    int fanIndex = findLabel(strtok_r(nullptr, " ", save), daikinSetFanLabel, 6);
+    if (modeIndex < 0) return commandError(reply, replySize, "mode fan|dry|cool");
+    if (fanIndex < 0) return commandError(reply, replySize, "fan quiet|auto|min|med|max|turbo");
+    if (!parseOnOff(strtok_r(nullptr, " ", save), swing)) return commandError(reply, replySize, "swing on|off");
+    const char *toggle = strtok_r(nullptr, " ", save);
+
+    daikinAcApplyState(temp, modeIndex, fanIndex, swing, toggle != nullptr && strcmp(toggle, "toggle") == 0);
+    return true;
+  }
+
+  return commandError(reply, replySize, "expected sharp|daikin");
+}
+
+bool commandSwitch(char *number, char *value, char *reply, size_t replySize) {
+  int switchIndex = number ? atoi(number) - 1 : -1;
+  if (switchIndex < 0 || switchIndex > 3) return commandError(reply, replySize, "switch 1-4");
+
+  bool state;
+  if (value != nullptr && strcmp(value, "toggle") == 0) state = !getSwitchState(switchIndex);
+  else if (!parseOnOff(value, state)) return commandError(reply, replySize, "expected on|off|toggle");
+
+  setSwitchState(switchIndex, state);
+  snprintf(reply, replySize, "switch%d=%s", switchIndex + 1, state ? "on" : "off");
+  return true;
+}
+
+bool commandScene(char *name, char *reply, size_t replySize) {
+  for (const Scene &scene : scenes) {
+    if (name == nullptr || strcmp(name, scene.name) != 0) continue;
+
+    int step = 0;
+    for (; scene.steps[step] != nullptr; step++) {
+      char line[SERIAL_LINE_LENGTH];
+      char stepReply[SERIAL_REPLY_LENGTH] = "";
+      strlcpy(line, scene.steps[step], sizeof(line));
+      if (!executeCommand(line, stepReply, sizeof(stepReply))) {
+        snprintf(reply, replySize, "step %d (%s): %s", step + 1, scene.steps[step], stepReply);
+        return false;
+      }
+    }
+    snprintf(reply, replySize, "steps=%d", step);
+    return true;
+  }
+  snprintf(reply, replySize, "unknown scene %s", name ? name : "");
+  return false;
+}
+
+void commandState(char *reply, size_t replySize) {
+  snprintf(reply, replySize, "sharp=%s,%u,%s,%s,%s daikin=%u,%s,%s,%s switches=%d%d%d%d",
+           currentPowerState ? "on" : "off", sharpSetTemp, sharpSetModeLabel[sharpSetModeIndex], sharpSetFanLabel[sharpSetFanIndex],
+           sharpSetSwing ? "on" : "off", daikinSetTemp, daikinSetModeLabel[daikinSetModeIndex], daikinSetFanLabel[daikinSetFanIndex],
+           daikinSetSwing ? "on" : "off", getSwitchState(0), getSwitchState(1), getSwitchState(2), getSwitchState(3));
+}
+
+// Executes one command line (without id). Returns false with the reason in reply on error.
+bool executeCommand(char *line, char *reply, size_t replySize) {
+  char *save = nullptr;
+  char *command = strtok_r(line, " ", &save);
+  if (command == nullptr) return commandError(reply, replySize, "missing command");
+
+  if (strcmp(command, "ir") == 0) return commandIr(strtok_r(nullptr, " ", &save), reply, replySize);
+  if (strcmp(command, "ac") == 0) return commandAc(strtok_r(nullptr, " ", &save), &save, reply, replySize);
+  if (strcmp(command, "switch") == 0) {
+    char *number = strtok_r(nullptr, " ", &save);
+    return commandSwitch(number, strtok_r(nullptr, " ", &save), reply, replySize);
+  }
+  if (strcmp(command, "scene") == 0) return commandScene(strtok_r(nullptr, " ", &save), reply, replySize);
+  if (strcmp(command, "state") == 0) {
+    commandState(reply, replySize);
+    return true;
+  }
+  if (strcmp(command, "metrics") == 0) {
+    formatMetrics(reply, replySize);
+    return true;
+  }
+
+  snprintf(reply, replySize, "unknown command %s", command);
+  return false;
+}
+
+/*===================================== QUEUE ======================================*/
+// The id is the first token of the line
+void copyId(const char *line, char *id) {
+  uint8_t i = 0;
+  while (line[i] != '\0' && line[i] != ' ' && i < SERIAL_ID_LENGTH - 1) {
+    id[i] = line[i];
+    i++;
+  }
+  id[i] = '\0';
+}
+
+void queueSerialLine() {
+  char id[SERIAL_ID_LENGTH];
+  copyId(serialInput, id);
+
+  if (serialInputOverflow) {
+    serialReply(id, false, "line too long");
+    return;
+  }
+  if (serialQueueCount >= SERIAL_QUEUE_SIZE) {
+    metrics.serialDropped++;
+    serialReply(id, false, "busy");
+    return;
+  }
+
+  memcpy(serialQueue[(serialQueueHead + serialQueueCount) % SERIAL_QUEUE_SIZE], serialInput, serialInputLength + 1);
+  serialQueueCount++;
+  metrics.serialReceived++;
+  metrics.serialQueuePeak = max(metrics.serialQueuePeak, (uint32_t)serialQueueCount);
+}
+
+// Collect the bytes already received, never waits for more
+bool readSerialInput() {
+  bool received = false;
+
+  while (Serial.available() > 0) {
+    char c = Serial.read();
+    if (c == '\r') continue;
+    if (c != '\n') {
+      if (serialInputLength < SERIAL_LINE_LENGTH - 1) serialInput[serialInputLength++] = c;
+      else serialInputOverflow = true;
+      continue;
+    }
+
+    serialInput[serialInputLength] = '\0';
+    if (serialInputLength > 0) {
+      queueSerialLine();
+      received = true;
+    }
+    serialInputLength = 0;
+    serialInputOverflow = false;
+  }
+  return received;
+}
+
+void executeQueuedLine(char *line) {
+  char id[SERIAL_ID_LENGTH];
+  char reply[SERIAL_REPLY_LENGTH] = "";
+  copyId(line, id);
+
+  char *command = strchr(line, ' ');
+  if (command == nullptr) {
+    serialReply(id, false, "missing command");
+    return;
+  }
+  // Commands only start their IR frames and switch sends, the response waits until they are out
+  irFlushDeferred = true;
+  bool ok = executeCommand(command + 1, reply, sizeof(reply));
+  irFlushDeferred = false;
+
+  if (irPoll() || switchSendPoll()) {
+    serialReplyPending = true;
+    serialPendingOk = ok;
+    strlcpy(serialPendingId, id, sizeof(serialPendingId));
+    strlcpy(serialPendingReply, reply, sizeof(serialPendingReply));
+    return;
+  }
+  serialReply(id, ok, reply);
+}
+
+bool serialCommandLoop() {
+  bool received = readSerialInput();
+
+  // The next command starts once the previous one is on the air, so frames are never dropped from a full emitter queue
+  if (serialReplyPending) {
+    if (irPoll() || switchSendPoll()) return received;
+    serialReplyPending = false;
+    serialReply(serialPendingId, serialPendingOk, serialPendingReply);
+  }
+
+  // Execute queued commands until the time budget is used or one is transmitting, the rest waits for the next loop()
+  unsigned long start = millis();
+  while (serialQueueCount > 0 && !serialReplyPending && millis() - start < SERIAL_EXECUTE_BUDGET) {
+    executeQueuedLine(serialQueue[serialQueueHead]);
+    serialQueueHead = (serialQueueHead + 1) % SERIAL_QUEUE_SIZE;
+    serialQueueCount--;
+  }
+  return received;
+}
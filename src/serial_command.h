@@ -0,0 +1,32 @@
+#ifndef SERIAL_COMMAND_H
+#define SERIAL_COMMAND_H
+
+#include <stdint.h>
+
+// Line based command interface on Serial (115200 baud) for scripts and the home server.
+//
+// Request:  <id> <command> [arguments...]\n      (id: any token chosen by the host, echoed back)
+// Response: <id> OK [data]\n  or  <id> ERR <reason>\n
+//
+//   ir <name>                                     send a named IR code (see irCodes in serial_command.cpp)
+//   ac sharp off
+//   ac sharp on <temp> <mode> <fan> <swing on|off>   full Sharp A/C state, mode/fan by menu label
+//   ac daikin <temp> <mode> <fan> <swing on|off> [toggle]   full Daikin state, "toggle" also toggles power
+//   switch <1-4> <on|off|toggle>
+//   scene <name>                                  run a list of commands (see scenes in serial_command.cpp)
+//   state                                         A/C settings and switch states
+//   metrics                                       runtime counters (see metrics.h)
+//
+// Lines are read without blocking and queued.
+// A host can pipeline commands and match the responses by id.
+// Nothing waits for the radio. A command starts its IR frames or switch send.
+// Its response comes once they are out, then the next command runs.
+// Keep at most SERIAL_QUEUE_SIZE commands in flight. A full queue answers "ERR busy" right away.
+// Debug output may be interleaved. Responses are the lines whose second token is OK or ERR.
+
+const uint8_t SERIAL_QUEUE_SIZE = 32;
+const uint8_t SERIAL_LINE_LENGTH = 64;
+
+bool serialCommandLoop();  // Put this in the void loop in the main.cpp. Returns true when commands were received
+
+#endif
@@ -0,0 +1,198 @@
+#include "settings.h"
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <esp_rom_crc.h>
+
+#include "ESPNOW.h"
+#include "ir_aircond.h"
+#include "shortcuts.h"
+
+const uint32_t JOURNAL_MAGIC = 0x4A524E4C;  // "JRNL"
+const uint32_t JOURNAL_SECTOR_SIZE = 4096;
+const unsigned long SETTINGS_IDLE_FLUSH = 5000;  // Duration (ms) without changes before writing to flash
+
+// One journal entry. Every record holds a full snapshot, so loading only needs the newest valid record.
+struct JournalRecord {
+  uint32_t magic;
+  uint32_t sequence;  // Increases with every record, used to find the newest sector
+  PersistentState state;
+  uint32_t crc;  // CRC32 of everything above
+};
+static_assert(sizeof(JournalRecord) == 32, "Journal record must stay 32 bytes");
+
+const uint32_t RECORDS_PER_SECTOR = JOURNAL_SECTOR_SIZE / sizeof(JournalRecord);
+
+const esp_partition_t *journalPartition = nullptr;
+uint32_t journalSectorCount = 0;
+uint32_t journalWriteSector = 0;  // Sector of the next record
+uint32_t journalWriteSlot = 0;    // Record index inside journalWriteSector
+uint32_t journalSequence = 0;
+bool journalSectorErased = false;  // False until journalWriteSector is known to be erased from journalWriteSlot on
+
+PersistentState committedSettings;  // Last state written to (or loaded from) flash
+bool settingsDirty = false;
+unsigned long lastSettingsChange = 0;
+
+uint32_t recordCrc(const JournalRecord &record) {
+  return esp_rom_crc32_le(0, (const uint8_t *)&record, offsetof(JournalRecord, crc));
+}
+
+bool readJournalRecord(uint32_t sector, uint32_t slot, JournalRecord &record) {
+  uint32_t offset = sector * JOURNAL_SECTOR_SIZE + slot * sizeof(JournalRecord);
+  return esp_partition_read(journalPartition, offset, &record, sizeof(record)) == ESP_OK;
+}
+
+bool isValidRecord(const JournalRecord &record) {
+  return record.magic == JOURNAL_MAGIC && record.crc == recordCrc(record);
+}
+
+bool isErasedRecord(const JournalRecord &record) {
+  return record.magic == 0xFFFFFFFF;
+}
+
+// Copy the live settings into a snapshot
+void captureSettings(PersistentState &state) {
+  memset(&state, 0, sizeof(state));
+  state.sharpSetTemp = sharpSetTemp;
+  state.sharpSetModeIndex = sharpSetModeIndex;
+  state.sharpSetFanIndex = sharpSetFanIndex;
+  state.sharpSetSwing = sharpSetSwing;
+  state.sharpPowerState = currentPowerState;
+  state.daikinSetTemp = daikinSetTemp;
+  state.daikinSetModeIndex = daikinSetModeIndex;
+  state.daikinSetFanIndex = daikinSetFanIndex;
+  state.daikinSetSwing = daikinSetSwing;
+  for (int i = 0; i < 4; i++) state.switchState[i] = getSwitchState(i);
+  topShortcuts(state.shortcutPath, SHORTCUT_PERSISTED);
+}
+
+// Apply a snapshot to the live settings. Values out of range are ignored.
+void applySettings(const PersistentState &state) {
+  if (state.sharpSetTemp >= 16 && state.sharpSetTemp <= 30) sharpSetTemp = state.sharpSetTemp;
+  if (state.sharpSetModeIndex <= 2) sharpSetModeIndex = state.sharpSetModeIndex;
+  if (state.sharpSetFanIndex <= 3) sharpSetFanIndex = state.sharpSetFanIndex;
+  sharpSetSwing = state.sharpSetSwing;
+  currentPowerState = state.sharpPowerState;
+  if (state.daikinSetTemp >= 16 && state.daikinSetTemp <= 30) daikinSetTemp = state.daikinSetTemp;
+  if (state.daikinSetModeIndex <= 2) daikinSetModeIndex = state.daikinSetModeIndex;
+  if (state.daikinSetFanIndex <= 5) daikinSetFanIndex = state.daikinSetFanIndex;
+  daikinSetSwing = state.daikinSetSwing;
+  for (int i = 0; i < 4; i++) restoreSwitchState(i, state.switchState[i]);
+  restoreShortcuts(state.shortcutPath, SHORTCUT_PERSISTED);
+}
+
+// Binary search for the first erased slot. Records are appended in order, so the erased slots
+// are always a suffix of the sector (a torn write is never erased, it is just invalid).
+uint32_t findFirstErasedSlot(uint32_t sector) {
+  uint32_t low = 0, high = RECORDS_PER_SECTOR;
+  JournalRecord record;
+
+  while (low < high) {
+    uint32_t mid = (low + high) / 2;
+    if (readJournalRecord(sector, mid, record) && isErasedRecord(record)) high = mid;
+    else low = mid + 1;
+  }
+  return low;
+}
+
+void loadSettings() {
+  journalPartition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)0x40, "journal");
+  if (journalPartition == nullptr) {
+    Serial.println("Settings journal partition not found");
+    return;
+  }
+  journalSectorCount = journalPartition->size / JOURNAL_SECTOR_SIZE;
+
+  // Find the newest sector by the sequence number of its first record: O(sectors)
+  JournalRecord record;
+  bool found = false;
+  uint32_t newestSector = 0, newestSequence = 0;
+  for (uint32_t sector = 0; sector < journalSectorCount; sector++) {
+    if (!readJournalRecord(sector, 0, record) || !isValidRecord(record)) continue;
+    if (!found || (int32_t)(record.sequence - newestSequence) > 0) {
+      newestSector = sector;
+      newestSequence = record.sequence;
+      found = true;
+    }
+  }
+
+  captureSettings(committedSettings);  // Defaults until a valid record is found
+
+  if (!found) {
+    journalWriteSector = 0;
+    journalWriteSlot = 0;
+    journalSectorErased = false;
+    return;
+  }
+
+  // Newest record: last valid slot before the erased suffix. Only a torn write makes us step back.
+  uint32_t firstErased = findFirstErasedSlot(newestSector);
+  for (int32_t slot = firstErased - 1; slot >= 0; slot--) {
+    if (readJournalRecord(newestSector, slot, record) && isValidRecord(record)) {
+      applySettings(record.state);
+      captureSettings(committedSettings);
+      journalSequence = record.sequence + 1;
+      break;
+    }
+  }
+
+  journalWriteSector = newestSector;
+  journalWriteSlot = firstErased;
+  journalSectorErased = true;
+}
+
+// Move to the next sector of the ring, recycling the oldest one
+void advanceJournalSector() {
+  journalWriteSector = (journalWriteSector + 1) % journalSectorCount;
+  journalWriteSlot = 0;
+  journalSectorErased = false;
+}
+
+bool appendJournalRecord(const PersistentState &state) {
+  if (journalWriteSlot >= RECORDS_PER_SECTOR) advanceJournalSector();
+
+  if (!journalSectorErased) {
+    if (esp_partition_erase_range(journalPartition, journalWriteSector * JOURNAL_SECTOR_SIZE, JOURNAL_SECTOR_SIZE) != ESP_OK) return false;
+    journalWriteSlot = 0;
+    journalSectorErased = true;
+  }
+
+  JournalRecord record;
+  record.magic = JOURNAL_MAGIC;
+  record.sequence = journalSequence;
+  record.state = state;
+  record.crc = recordCrc(record);
+
+  uint32_t offset = journalWriteSector * JOURNAL_SECTOR_SIZE + journalWriteSlot * sizeof(JournalRecord);
+  esp_err_t result = esp_partition_write(journalPartition, offset, &record, sizeof(record));
+
+  // Whatever happened, this slot is no longer erased
+  journalWriteSlot++;
+  if (result != ESP_OK) return false;
+
+  journalSequence++;
+  return true;
+}
+
+void markSettingsDirty() {
+  settingsDirty = true;
+  lastSettingsChange = millis();
+}
+
+void flushSettings() {
+  if (!settingsDirty || journalPartition == nullptr) return;
+  settingsDirty = false;
+
+  // Changes that cancel out (e.g. 20 -> 25 -> 20 °C) do not touch the flash
+  PersistentState state;
+  captureSettings(state);
+  if (memcmp(&state, &committedSettings, sizeof(state)) == 0) return;
+
+  if (appendJournalRecord(state)) committedSettings = state;
+  else Serial.println("Error writing settings journal");
+}
+
+void flushSettingsIfIdle() {
+  if (settingsDirty && millis() - lastSettingsChange >= SETTINGS_IDLE_FLUSH) flushSettings();
+}
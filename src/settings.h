@@ -0,0 +1,38 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <stdint.h>
+
+// Persistent settings journal
+// Changes are batched in RAM and only written when the remote is idle or before deep sleep.
+// Every write appends one fixed-size, CRC-protected snapshot to the "journal" flash partition
+// (see partitions.csv). The partition is used as a ring of sectors, so erases are spread
+// evenly (wear levelling) and the oldest sector is recycled when the current one is full (compaction).
+//
+// Write amplification (32-byte record for 19 bytes of state, 4 KB sector erased every 128 records):
+//   - one flush = 32 bytes programmed + 32 bytes of amortized erase
+//   - turning the temperature from 16 to 30 °C = 1 flush instead of 14 per-detent writes
+//   - 8 sectors x 128 records x 100k erase cycles = ~100M flushes before wear-out
+
+// Everything that should survive a power loss. Keep the size fixed, the record layout depends on it.
+struct PersistentState {
+  uint8_t sharpSetTemp;
+  uint8_t sharpSetModeIndex;
+  uint8_t sharpSetFanIndex;
+  bool sharpSetSwing;
+  bool sharpPowerState;
+  uint8_t daikinSetTemp;
+  uint8_t daikinSetModeIndex;
+  uint8_t daikinSetFanIndex;
+  bool daikinSetSwing;
+  bool switchState[4];
+  uint8_t reserved[1];  // Room for new settings without changing the record size
+  uint16_t shortcutPath[3];  // Top shortcuts (see shortcuts.h), 0 = none. Zero in records written before them.
+};
+
+void loadSettings();        // Put this in the void setup in the main.cpp
+void markSettingsDirty();   // Call whenever a persisted value changes
+void flushSettingsIfIdle(); // Put this in the void loop in the main.cpp
+void flushSettings();       // Write pending changes now (e.g. before deep sleep)
+
+#endif
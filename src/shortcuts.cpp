@@ -0,0 +1,104 @@
+#include "shortcuts.h"
+
+#include <Arduino.h>
+
+#include "settings.h"
+
+const uint8_t SHORTCUT_TRACKED = 12;     // Actions with a score; the lowest one is replaced by a new action
+const uint16_t SHORTCUT_USE_SCORE = 100;  // Added on every use, before that all scores lose 1/8 (recency)
+const uint8_t FIRST_COMMAND_SAMPLES = 9;  // Wake-ups kept for the median
+
+struct ShortcutUsage {
+  uint16_t path;  // 0 = free
+  uint16_t score;
+};
+
+// RTC_DATA_ATTR keeps the ranking and the samples through deep sleep
+RTC_DATA_ATTR ShortcutUsage shortcutUsage[SHORTCUT_TRACKED];
+RTC_DATA_ATTR uint16_t firstCommandMs[FIRST_COMMAND_SAMPLES];
+RTC_DATA_ATTR uint8_t firstCommandCount = 0;  // Samples recorded, up to FIRST_COMMAND_SAMPLES
+RTC_DATA_ATTR uint8_t firstCommandNext = 0;
+bool firstCommandRecorded = false;
+
+void recordShortcutUse(uint16_t path) {
+  if (path == 0) return;
+
+  uint16_t topBefore[SHORTCUT_PERSISTED] = {};
+  topShortcuts(topBefore, SHORTCUT_PERSISTED);
+
+  ShortcutUsage *usage = nullptr;
+  ShortcutUsage *lowest = &shortcutUsage[0];
+  for (ShortcutUsage &entry : shortcutUsage) {
+    entry.score -= entry.score >> 3;
+    if (entry.path == path) usage = &entry;
+    if (entry.path == 0 || (lowest->path != 0 && entry.score < lowest->score)) lowest = &entry;
+  }
+
+  if (usage == nullptr) {
+    usage = lowest;
+    usage->path = path;
+    usage->score = 0;
+  }
+  usage->score += SHORTCUT_USE_SCORE;  // Scores settle below 8 x SHORTCUT_USE_SCORE, no overflow
+
+  // Only a new ranking needs to reach the flash
+  uint16_t topAfter[SHORTCUT_PERSISTED] = {};
+  topShortcuts(topAfter, SHORTCUT_PERSISTED);
+  if (memcmp(topBefore, topAfter, sizeof(topAfter)) != 0) markSettingsDirty();
+}
+
+uint8_t topShortcuts(uint16_t *paths, uint8_t maxCount) {
+  ShortcutUsage ranked[SHORTCUT_TRACKED];
+  uint8_t count = 0;
+
+  // Insertion sort by score, ties keep the table order
+  for (const ShortcutUsage &entry : shortcutUsage) {
+    if (entry.path == 0) continue;
+    uint8_t position = count++;
+    for (; position > 0 && ranked[position - 1].score < entry.score; position--) ranked[position] = ranked[position - 1];
+    ranked[position] = entry;
+  }
+
+  if (count > maxCount) count = maxCount;
+  for (uint8_t i = 0; i < count; i++) paths[i] = ranked[i].path;
+  return count;
+}
+
+void restoreShortcuts(const uint16_t *paths, uint8_t count) {
+  for (const ShortcutUsage &entry : shortcutUsage) {
+    if (entry.path != 0) return;  // Woken up from deep sleep: the RTC ranking is newer
+  }
+
+  for (uint8_t i = 0; i < count && i < SHORTCUT_TRACKED; i++) {
+    shortcutUsage[i].path = paths[i];
+    shortcutUsage[i].score = paths[i] != 0 ? (count - i) * SHORTCUT_USE_SCORE : 0;
+  }
+}
+
+void recordFirstCommand() {
+  if (firstCommandRecorded) return;
+  firstCommandRecorded = true;
+
+  unsigned long elapsed = millis();  // Deep sleep restarts the clock, so this is the time since wake-up
+  firstCommandMs[firstCommandNext] = elapsed > 65535 ? 65535 : elapsed;
+  firstCommandNext = (firstCommandNext + 1) % FIRST_COMMAND_SAMPLES;
+  if (firstCommandCount < FIRST_COMMAND_SAMPLES) firstCommandCount++;
+}
+
+uint32_t firstCommandMedianMs() {
+  if (firstCommandCount == 0) return 0;
+
+  uint16_t sorted[FIRST_COMMAND_SAMPLES];
+  memcpy(sorted, firstCommandMs, sizeof(sorted));
+  for (uint8_t i = 1; i < firstCommandCount; i++) {
+    uint16_t value = sorted[i];
+    uint8_t j = i;
+    for (; j > 0 && sorted[j - 1] > value; j--) sorted[j] = sorted[j - 1];
+    sorted[j] = value;
+  }
+  return sorted[firstCommandCount / 2];
+}
+
+uint8_t firstCommandSamples() {
+  return firstCommandCount;
+}
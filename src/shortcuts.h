@@ -0,0 +1,23 @@
+#ifndef SHORTCUTS_H
+#define SHORTCUTS_H
+
+#include <stdint.h>
+
+// Most used menu actions, ranked by frecency (how often and how recently they were used).
+// An action is identified by its menu path: one nibble (item index + 1) per menu level, starting
+// from mainMenu, e.g. 0x233 = mainMenu[1] > irSendMenu[2] > daikinAcMenu[2]. The path stays valid
+// as long as the menus keep their order. Scores are kept in RTC memory (deep sleep); the top
+// SHORTCUT_PERSISTED paths are also saved in the settings journal to survive a power loss.
+// The time from boot/wake-up to the first menu command is recorded for the "metrics" command.
+
+const uint8_t SHORTCUT_PERSISTED = 3;  // Paths stored in PersistentState
+
+void recordShortcutUse(uint16_t path);                        // Call when a menu action is executed
+uint8_t topShortcuts(uint16_t *paths, uint8_t maxCount);      // Highest scores first, returns the number of paths
+void restoreShortcuts(const uint16_t *paths, uint8_t count);  // Seed the scores after a power loss (ignored after deep sleep)
+
+void recordFirstCommand();         // Call on every menu command, only the first one after boot counts
+uint32_t firstCommandMedianMs();   // Over the last wake-ups, 0 until one was recorded
+uint8_t firstCommandSamples();
+
+#endif
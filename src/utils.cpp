@@ -1,5 +1,13 @@
 #include "utils.h"
 
+#include "ESPNOW.h"
+#include "delta_ota.h"
+#include "ir_emitter.h"
+#include "scheduler.h"
+#include "settings.h"
+
+#define SELECT_BUTTON 32
+
 // 'QR Code', 64x64px
 const unsigned char bitmap_QR_Code[] PROGMEM = {
   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
@@ -36,11 +44,8 @@ const unsigned char bitmap_QR_Code[] PROGMEM = {
   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
 
 void displayInfo() {
-  const char *versionTitle = "Version: ";
-  char versionInfo[20];
-
-  strcpy(versionInfo, versionTitle);
-  strcat(versionInfo, version);
+  char versionInfo[32];
+  snprintf(versionInfo, sizeof(versionInfo), "Version: %s", version);
 
   u8g2.setFont(u8g2_font_4x6_tr);
   u8g2.drawStr(0, 13, "Project: Home Remote");
@@ -54,6 +59,23 @@ void displayQr() {
   u8g2.drawXBMP(32, 0, 64, 64, bitmap_QR_Code);
 }
 
+// Delta firmware update status. ESP-NOW listens while it is open (see updateMenuSubscriptions() in main.cpp),
+// so the remote can receive or seed a patch. An offered update is installed with a press of the button.
+void firmwareUpdateUI() {
+  const char *statusLabel[] = {"Waiting for peers", "Press to install", "Seeding patch", "Receiving patch", "Updated, rebooting", "Update failed"};
+  uint8_t progress = deltaOtaProgress();
+  char progressStr[8];
+  sprintf(progressStr, "%u%%", progress);
+
+  u8g2.setFont(u8g2_font_6x13_tr);
+  u8g2.drawStr(0, 13, "Firmware Update");
+  u8g2.setFont(u8g2_font_profont11_tr);
+  u8g2.drawStr(0, 30, statusLabel[deltaOtaState()]);
+  u8g2.drawFrame(0, 40, 100, 10);
+  u8g2.drawBox(0, 40, progress, 10);
+  u8g2.drawStr(104, 49, progressStr);
+}
+
 // To check display activity
 int fpsCounter() {
   static unsigned long startCount = millis();
@@ -77,6 +99,15 @@ void underDevelopment() {
   u8g2.drawStr(13, 37, "Under Development");
 }
 
+// Arm every wake-up source (select button and pending scheduled jobs) and enter deep sleep
+void enterDeepSleep() {
+  while (irPoll() || switchSendPoll()) delay(1);  // Let queued IR frames and switch sends go out
+  flushSettings();  // Write pending setting changes before RAM is lost
+  esp_sleep_enable_ext0_wakeup((gpio_num_t)SELECT_BUTTON, 0);  // EXT0 wake-up on select button (active-low)
+  armSchedulerWakeup();
+  esp_deep_sleep_start();
+}
+
 void exitToSleep() {
   // Optionally display a "Confirm Sleep" screen first
   // Then execute deep sleep:
@@ -86,5 +117,5 @@ void exitToSleep() {
   delay(1500);
   u8g2.setPowerSave(1);
   delay(1000);
-  esp_deep_sleep_start();
+  enterDeepSleep();
 }
\ No newline at end of file
@@ -7,9 +7,11 @@ extern U8G2_SH1106_128X64_NONAME_F_HW_I2C u8g2;
 
 extern const char *version;
 
+void enterDeepSleep();
 void exitToSleep();
 void displayInfo();
 void displayQr();
+void firmwareUpdateUI();
 int fpsCounter();
 void underDevelopment();
 
@@ -0,0 +1,250 @@
+#include "websocket_client.h"
+
+#include <WebSocketsClient.h>
+
+#include "ESPNOW.h"
+#include "ir_aircond.h"
+#include "settings.h"
+#include "utils.h"
+#include "wifi_client.h"
+
+// REPLACE WITH YOUR HOME SERVER ADDRESS
+const char *wsHost = "192.168.1.100";
+const uint16_t wsPort = 8080;
+const char *wsPath = "/remote";
+
+WebSocketsClient webSocket;
+
+enum WsState { WS_IDLE, WS_WAIT_WIFI, WS_CONNECTING, WS_CONNECTED };
+WsState wsState = WS_IDLE;
+
+const uint8_t WS_HEADER_LENGTH = 4;
+const uint8_t WS_MAX_PAYLOAD = 12;
+const uint8_t WS_MAX_IN_FLIGHT = 16;          // Pipelined requests awaiting a response
+const uint8_t WS_OUTBOX_SIZE = 16;            // Requests queued while offline or while the pipeline is full
+const unsigned long WS_RESPONSE_TIMEOUT = 5000;  // Duration (ms) before an unanswered request is dropped
+
+struct WsFrame {
+  uint8_t length;
+  uint8_t data[WS_HEADER_LENGTH + WS_MAX_PAYLOAD];
+};
+
+struct WsPending {
+  bool used;
+  uint8_t sequence;
+  unsigned long sentAt;
+};
+
+WsFrame wsOutbox[WS_OUTBOX_SIZE];
+uint8_t wsOutboxHead = 0;
+uint8_t wsOutboxCount = 0;
+
+WsPending wsInFlight[WS_MAX_IN_FLIGHT];
+uint8_t wsInFlightCount = 0;
+
+uint8_t wsNextSequence = 0;
+unsigned long wsLastRoundTrip = 0;  // Round-trip time (ms) of the latest answered request
+unsigned long wsSentCount = 0;
+unsigned long wsDroppedCount = 0;
+
+// Transmit a frame now and track it until its response arrives
+bool wsTransmitFrame(const WsFrame &frame) {
+  for (int i = 0; i < WS_MAX_IN_FLIGHT; i++) {
+    if (wsInFlight[i].used) continue;
+
+    if (!webSocket.sendBIN(frame.data, frame.length)) return false;
+    wsInFlight[i] = {true, frame.data[1], millis()};
+    wsInFlightCount++;
+    wsSentCount++;
+    return true;
+  }
+  return false;
+}
+
+// Send queued frames as long as the pipeline has room
+void wsFlushOutbox() {
+  while (wsState == WS_CONNECTED && wsOutboxCount > 0 && wsInFlightCount < WS_MAX_IN_FLIGHT) {
+    if (!wsTransmitFrame(wsOutbox[wsOutboxHead])) return;
+    wsOutboxHead = (wsOutboxHead + 1) % WS_OUTBOX_SIZE;
+    wsOutboxCount--;
+  }
+}
+
+bool wsSendFrame(WsOpcode opcode, uint8_t target, const uint8_t *payload, uint8_t length) {
+  if (length > WS_MAX_PAYLOAD) return false;
+
+  WsFrame frame;
+  frame.length = WS_HEADER_LENGTH + length;
+  frame.data[0] = opcode;
+  frame.data[1] = wsNextSequence++;
+  frame.data[2] = target;
+  frame.data[3] = length;
+  memcpy(&frame.data[WS_HEADER_LENGTH], payload, length);
+
+  webSocketConnect();  // Connect on first use
+
+  // Keep the order of queued frames: only bypass the wsOutbox when it is empty
+  if (wsState == WS_CONNECTED && wsOutboxCount == 0 && wsInFlightCount < WS_MAX_IN_FLIGHT && wsTransmitFrame(frame)) return true;
+
+  if (wsOutboxCount >= WS_OUTBOX_SIZE) {
+    wsDroppedCount++;
+    return false;
+  }
+  wsOutbox[(wsOutboxHead + wsOutboxCount) % WS_OUTBOX_SIZE] = frame;
+  wsOutboxCount++;
+  return true;
+}
+
+// Apply a switch state reported by the server
+void wsApplySwitchState(uint8_t switchIndex, uint8_t state) {
+  if (switchIndex < 4 && restoreSwitchState(switchIndex, state)) markSettingsDirty();
+}
+
+void wsHandleMessage(const uint8_t *payload, size_t length) {
+  if (length < WS_HEADER_LENGTH || length < (size_t)(WS_HEADER_LENGTH + payload[3])) return;
+
+  uint8_t opcode = payload[0];
+
+  if (opcode == WS_OP_STATE_PUSH) {
+    if (payload[3] >= 1) wsApplySwitchState(payload[2], payload[WS_HEADER_LENGTH]);
+    return;
+  }
+
+  if (!(opcode & WS_RESPONSE_FLAG)) return;
+
+  for (int i = 0; i < WS_MAX_IN_FLIGHT; i++) {
+    if (!wsInFlight[i].used || wsInFlight[i].sequence != payload[1]) continue;
+    wsLastRoundTrip = millis() - wsInFlight[i].sentAt;
+    wsInFlight[i].used = false;
+    wsInFlightCount--;
+    break;
+  }
+
+  // Switch responses carry the actual state of the switch
+  if ((opcode & ~WS_RESPONSE_FLAG) == WS_OP_SWITCH_SET && payload[2] == WS_STATUS_OK && payload[3] >= 2) {
+    wsApplySwitchState(payload[WS_HEADER_LENGTH], payload[WS_HEADER_LENGTH + 1]);
+  }
+
+  wsFlushOutbox();
+}
+
+void webSocketEvent(WStype_t type, uint8_t *payload, size_t length) {
+  switch (type) {
+    case WStype_CONNECTED:
+      Serial.println("WebSocket connected");
+      wsState = WS_CONNECTED;
+      wsFlushOutbox();
+      break;
+    case WStype_DISCONNECTED:
+      if (wsState == WS_CONNECTED) Serial.println("WebSocket disconnected");
+      if (wsState != WS_IDLE) wsState = WS_CONNECTING;  // The library reconnects by itself
+      // Requests in flight are lost with the connection
+      wsDroppedCount += wsInFlightCount;
+      memset(wsInFlight, 0, sizeof(wsInFlight));
+      wsInFlightCount = 0;
+      break;
+    case WStype_BIN:
+      wsHandleMessage(payload, length);
+      break;
+    default:
+      break;
+  }
+}
+
+// Drop requests that never got a response so the pipeline cannot stall
+void wsExpireInFlight() {
+  unsigned long now = millis();
+  for (int i = 0; i < WS_MAX_IN_FLIGHT; i++) {
+    if (wsInFlight[i].used && now - wsInFlight[i].sentAt > WS_RESPONSE_TIMEOUT) {
+      wsInFlight[i].used = false;
+      wsInFlightCount--;
+      wsDroppedCount++;
+    }
+  }
+}
+
+void webSocketConnect() {
+  if (wsState != WS_IDLE) return;
+  wifiBegin();
+  wsState = WS_WAIT_WIFI;
+}
+
+void webSocketDisconnect() {
+  if (wsState == WS_IDLE) return;
+  wsState = WS_IDLE;
+  webSocket.disconnect();
+  wifiEnd();
+  wsOutboxCount = 0;
+}
+
+bool webSocketActive() {
+  return wsState != WS_IDLE;
+}
+
+void webSocketLoop() {
+  if (wsState == WS_IDLE) return;
+
+  if (wsState == WS_WAIT_WIFI) {
+    if (!wifiConnected()) return;
+    webSocket.begin(wsHost, wsPort, wsPath);
+    webSocket.onEvent(webSocketEvent);
+    webSocket.setReconnectInterval(2000);
+    webSocket.enableHeartbeat(15000, 3000, 2);  // Ping every 15 s, drop the connection after 2 missed pongs
+    wsState = WS_CONNECTING;
+  }
+
+  webSocket.loop();
+  wsExpireInFlight();
+  wsFlushOutbox();
+}
+
+bool webSocketSendSwitch(uint8_t switchIndex, bool state) {
+  uint8_t payload[1] = {state};
+  return wsSendFrame(WS_OP_SWITCH_SET, switchIndex, payload, sizeof(payload));
+}
+
+bool webSocketSendAcState(WsAcTarget ac) {
+  uint8_t payload[5];
+  if (ac == WS_AC_SHARP) {
+    payload[0] = currentPowerState;
+    payload[1] = sharpSetTemp;
+    payload[2] = sharpSetModeIndex;
+    payload[3] = sharpSetFanIndex;
+    payload[4] = sharpSetSwing;
+  } else {
+    payload[0] = 1;  // Daikin power is toggle only, always report on
+    payload[1] = daikinSetTemp;
+    payload[2] = daikinSetModeIndex;
+    payload[3] = daikinSetFanIndex;
+    payload[4] = daikinSetSwing;
+  }
+  return wsSendFrame(WS_OP_AC_STATE, ac, payload, sizeof(payload));
+}
+
+bool webSocketSendIr(WsIrTarget protocol, uint64_t code, uint8_t nbits) {
+  uint8_t payload[9];
+  payload[0] = nbits;
+  for (int i = 0; i < 8; i++) payload[1 + i] = (code >> (8 * i)) & 0xFF;
+  return wsSendFrame(WS_OP_IR_SEND, protocol, payload, sizeof(payload));
+}
+
+void webSocketToggleSwitch(uint8_t switchIndex) {
+  webSocketSendSwitch(switchIndex, !getSwitchState(switchIndex));
+}
+
+// Renders the connection status on the OLED display. The connection is started when the menu is
+// entered (see updateMenuSubscriptions() in main.cpp), drawing never touches the radio.
+void webSocketStatusUI() {
+  const char *status = wsState == WS_CONNECTED ? "Connected" : wsState == WS_CONNECTING ? "Connecting..." : wsState == WS_WAIT_WIFI ? "Joining Wi-Fi..." : "Disconnected";
+  char line[24];
+
+  u8g2.setFont(u8g2_font_6x13_tr);
+  u8g2.drawStr(0, 13, status);
+  u8g2.setFont(u8g2_font_profont11_tr);
+  snprintf(line, sizeof(line), "RTT %lums WiFi %lums", wsLastRoundTrip, wifiLastConnectTime());
+  u8g2.drawStr(0, 30, line);
+  snprintf(line, sizeof(line), "In flight: %u/%u", wsInFlightCount + wsOutboxCount, WS_MAX_IN_FLIGHT);
+  u8g2.drawStr(0, 43, line);
+  snprintf(line, sizeof(line), "Sent: %lu Lost: %lu", wsSentCount, wsDroppedCount);
+  u8g2.drawStr(0, 56, line);
+}
@@ -0,0 +1,34 @@
+#ifndef WEBSOCKET_CLIENT_H
+#define WEBSOCKET_CLIENT_H
+
+#include <stdint.h>
+
+// Binary wire format, one WebSocket binary message per frame:
+//   Request  (remote -> server): [opcode][sequence][target][length][payload...]
+//   Response (server -> remote): [opcode | 0x80][sequence][status][length][payload...]
+// The connection stays open (ping/pong keepalive) and requests are pipelined: the sequence number
+// matches responses to requests, so a new command never waits for the previous response.
+enum WsOpcode : uint8_t {
+  WS_OP_SWITCH_SET = 0x01,  // target = switch index (0-3), payload = {state}
+  WS_OP_AC_STATE = 0x02,    // target = WS_AC_SHARP / WS_AC_DAIKIN, payload = {power, temp, mode index, fan index, swing}
+  WS_OP_IR_SEND = 0x03,     // target = WS_IR_NEC / WS_IR_RC6 / WS_IR_SYMPHONY, payload = {nbits, code (8 bytes, little endian)}
+  WS_OP_STATE_PUSH = 0x10,  // Server -> remote without request: target = switch index, payload = {state}
+};
+
+const uint8_t WS_RESPONSE_FLAG = 0x80;
+const uint8_t WS_STATUS_OK = 0;
+
+enum WsAcTarget : uint8_t { WS_AC_SHARP, WS_AC_DAIKIN };
+enum WsIrTarget : uint8_t { WS_IR_NEC, WS_IR_RC6, WS_IR_SYMPHONY };
+
+void webSocketLoop();  // Put this in the void loop in the main.cpp
+void webSocketConnect();
+void webSocketDisconnect();
+bool webSocketActive();  // Connecting or connected
+bool webSocketSendSwitch(uint8_t switchIndex, bool state);
+bool webSocketSendAcState(WsAcTarget ac);
+bool webSocketSendIr(WsIrTarget protocol, uint64_t code, uint8_t nbits);
+void webSocketToggleSwitch(uint8_t switchIndex);
+void webSocketStatusUI();
+
+#endif
@@ -0,0 +1,116 @@
+#include "wifi_client.h"
+
+#include <time.h>
+
+// REPLACE WITH YOUR WIFI CREDENTIALS
+const char *wifiSsid = "YOUR_SSID";
+const char *wifiPassword = "YOUR_PASSWORD";
+
+const unsigned long FAST_REJOIN_TIMEOUT = 1500;  // Duration (ms) before falling back to a full scan and DHCP
+const uint32_t WIFI_CACHE_MAX_AGE = 12 * 3600;   // Seconds a cached IP is reused before asking DHCP again
+
+// Last successful connection. RTC_DATA_ATTR keeps it through deep sleep so the next
+// connection can skip the channel scan and DHCP.
+struct WiFiCache {
+  bool valid;
+  uint8_t bssid[6];
+  int32_t channel;
+  uint32_t ip;
+  uint32_t gateway;
+  uint32_t subnet;
+  uint32_t dns;
+  uint32_t savedAt;  // RTC clock seconds
+};
+RTC_DATA_ATTR WiFiCache wifiCache;
+
+bool wifiStarted = false;
+bool wifiFastRejoin = false;         // Current attempt uses the cached BSSID, channel and IP
+bool wifiConnectReported = false;    // Connect time already measured for this attempt
+unsigned long wifiConnectStart = 0;
+unsigned long wifiConnectDuration = 0;  // Duration (ms) of the latest connection
+
+// Full connect: scan all channels and ask DHCP for an address
+void wifiBeginFullScan() {
+  WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));  // Back to DHCP
+  WiFi.begin(wifiSsid, wifiPassword);
+  wifiFastRejoin = false;
+}
+
+void wifiBegin() {
+  if (wifiStarted) return;
+
+  WiFi.persistent(false);  // Don't write the credentials to NVS on every connect
+  WiFi.mode(WIFI_STA);
+  WiFi.setSleep(false);  // Keep the radio awake for low latency while connected
+  wifiConnectStart = millis();
+  wifiConnectReported = false;
+
+  bool cacheFresh = (uint32_t)time(nullptr) - wifiCache.savedAt < WIFI_CACHE_MAX_AGE;
+  if (wifiCache.valid && cacheFresh) {
+    // Go straight to the known access point on the known channel with the previous lease
+    WiFi.config(IPAddress(wifiCache.ip), IPAddress(wifiCache.gateway), IPAddress(wifiCache.subnet), IPAddress(wifiCache.dns));
+    WiFi.begin(wifiSsid, wifiPassword, wifiCache.channel, wifiCache.bssid);
+    wifiFastRejoin = true;
+    Serial.println("Connecting to Wi-Fi (cached BSSID/channel)");
+  } else {
+    wifiBeginFullScan();
+    Serial.println("Connecting to Wi-Fi");
+  }
+  wifiStarted = true;
+}
+
+// Remember how we got connected for the next wake-up
+void wifiSaveCache() {
+  memcpy(wifiCache.bssid, WiFi.BSSID(), sizeof(wifiCache.bssid));
+  wifiCache.channel = WiFi.channel();
+  wifiCache.ip = WiFi.localIP();
+  wifiCache.gateway = WiFi.gatewayIP();
+  wifiCache.subnet = WiFi.subnetMask();
+  wifiCache.dns = WiFi.dnsIP();
+  // Keep the original lease time when the cached lease was reused
+  if (!wifiFastRejoin) wifiCache.savedAt = (uint32_t)time(nullptr);
+  wifiCache.valid = true;
+}
+
+bool wifiConnected() {
+  if (!wifiStarted) return false;
+
+  wl_status_t status = WiFi.status();
+
+  if (status == WL_CONNECTED) {
+    if (!wifiConnectReported) {
+      wifiConnectDuration = millis() - wifiConnectStart;
+      wifiConnectReported = true;
+      wifiSaveCache();
+      Serial.printf("Wi-Fi connected in %lu ms (%s)\n", wifiConnectDuration, wifiFastRejoin ? "fast rejoin" : "full scan");
+    }
+    return true;
+  }
+
+  // The access point moved or the lease is gone: forget the cache and do it the slow way
+  bool failed = status == WL_CONNECT_FAILED || status == WL_NO_SSID_AVAIL || millis() - wifiConnectStart > FAST_REJOIN_TIMEOUT;
+  if (wifiFastRejoin && failed) {
+    Serial.println("Fast rejoin failed, falling back to full scan");
+    wifiCache.valid = false;
+    WiFi.disconnect();
+    wifiBeginFullScan();
+  }
+  return false;
+}
+
+bool wifiActive() {
+  return wifiStarted;
+}
+
+unsigned long wifiLastConnectTime() {
+  return wifiConnectDuration;
+}
+
+void wifiEnd() {
+  if (!wifiStarted) return;
+
+  WiFi.disconnect(true);
+  WiFi.mode(WIFI_OFF);
+  wifiStarted = false;
+  Serial.println("Wi-Fi disconnected");
+}
@@ -0,0 +1,15 @@
+#ifndef WIFI_CLIENT_H
+#define WIFI_CLIENT_H
+
+#include <WiFi.h>
+
+// A successful connection is cached in RTC memory (BSSID, channel, IP configuration).
+// After deep sleep the next wifiBegin() rejoins that access point directly with the same
+// address, skipping the channel scan and DHCP, and falls back to a full connect on failure.
+void wifiBegin();      // Start connecting to the access point (non-blocking)
+bool wifiConnected();  // True once the station has an IP address
+bool wifiActive();     // True between wifiBegin() and wifiEnd()
+unsigned long wifiLastConnectTime();  // Duration (ms) from wifiBegin() to connected for the latest connection
+void wifiEnd();        // Disconnect and turn Wi-Fi off to save power
+
+#endif
@@ -0,0 +1,267 @@
+// Delta OTA receiver applying a signed tools/make_delta.py patch between two real firmware images,
+// and refusing unsigned, tampered or unconfirmed ones (pio test -e sim -f test_delta_ota)
+//
+// old.bin and new.bin are host builds of this firmware (src/, lib/ and sim/ with -Os, stripped) at two
+// revisions that differ by a small fix, the kind of change the delta update is made for.
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_now.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <unity.h>
+
+#include <string>
+
+#include "delta_ota.h"
+#include "espnow_message.h"
+#include "sim.h"
+
+// Signing key of the tests, deltaOtaKey in delta_ota.cpp is all zeros (updates disabled) until replaced
+const char *KEY = "6b7e1f0c2d3a4b5c6d7e8f90a1b2c3d4e5f60718293a4b5c6d7e8f9001122334";
+const char *OTHER_KEY = "00112233445566778899aabbccddeeff00112233445566778899aabbccddeeff";
+extern uint8_t deltaOtaKey[32];
+
+const char *OLD_IMAGE = "test/test_delta_ota/old.bin";
+const char *NEW_IMAGE = "test/test_delta_ota/new.bin";
+const uint8_t SEEDER_MAC[6] = {0x24, 0x6F, 0x28, 0x0A, 0x0B, 0x0C};
+const uint32_t CHUNK_SIZE = 200;           // OTA_CHUNK_SIZE in delta_ota.cpp
+const uint32_t HEADER_SIZE = sizeof(DeltaHeader);
+
+std::vector<uint8_t> oldImage, newImage, patch, otherKeyPatch;
+uint32_t session;
+
+std::vector<uint8_t> readFile(const std::string &path) {
+  std::vector<uint8_t> data;
+  FILE *file = fopen(path.c_str(), "rb");
+  if (file == nullptr) return data;
+  uint8_t block[4096];
+  size_t length;
+  while ((length = fread(block, 1, sizeof(block), file)) > 0) data.insert(data.end(), block, block + length);
+  fclose(file);
+  return data;
+}
+
+std::vector<uint8_t> makePatch(const char *key) {
+  std::string path = std::string(P_tmpdir) + "/test_delta_ota_patch.bin";
+  std::string command = std::string("python3 tools/make_delta.py --key ") + key + " " + OLD_IMAGE + " " + NEW_IMAGE + " " + path + " > /dev/null";
+  if (system(command.c_str()) != 0) return {};
+  return readFile(path);
+}
+
+void appendLe32(std::vector<uint8_t> &message, uint32_t value) {
+  for (int i = 0; i < 4; i++) message.push_back(value >> (8 * i));
+}
+
+// A message from the seeder, handled like the ESP-NOW receive callback and the next loop() would
+void deliver(const std::vector<uint8_t> &message) {
+  deltaOtaReceive(SEEDER_MAC, message.data(), message.size());
+  deltaOtaLoop();
+}
+
+void sendOffer(const std::vector<uint8_t> &source) {
+  std::vector<uint8_t> offer = {MSG_OTA_OFFER};
+  appendLe32(offer, source[48] | source[49] << 8 | source[50] << 16 | (uint32_t)source[51] << 24);  // Session: start of newSha256
+  offer.insert(offer.end(), source.begin(), source.begin() + HEADER_SIZE);
+  deliver(offer);
+}
+
+void offerAndAccept() {
+  sendOffer(patch);
+  TEST_ASSERT_EQUAL(DELTA_OTA_OFFERED, deltaOtaState());
+  TEST_ASSERT_TRUE(deltaOtaAccept());
+  TEST_ASSERT_EQUAL(DELTA_OTA_RECEIVING, deltaOtaState());
+}
+
+// MSG_OTA_REQUEST, MSG_OTA_ACK and MSG_OTA_DONE sent by the receiver
+int sentToSeeder() {
+  return simCountEvents(SIM_ESPNOW, "21") + simCountEvents(SIM_ESPNOW, "23") + simCountEvents(SIM_ESPNOW, "24");
+}
+
+uint32_t chunkCount() { return (patch.size() + CHUNK_SIZE - 1) / CHUNK_SIZE; }
+
+void sendChunk(uint32_t index, const std::vector<uint8_t> &source) {
+  uint32_t offset = index * CHUNK_SIZE;
+  uint32_t length = std::min<uint32_t>(CHUNK_SIZE, source.size() - offset);
+  std::vector<uint8_t> chunk = {MSG_OTA_CHUNK};
+  appendLe32(chunk, session);
+  appendLe32(chunk, index);
+  chunk.push_back(length);
+  chunk.insert(chunk.end(), source.begin() + offset, source.begin() + offset + length);
+  deliver(chunk);
+}
+
+// Status of the last MSG_OTA_DONE the receiver sent, -1 when it sent none
+int lastDoneStatus() {
+  for (auto event = simEvents.rbegin(); event != simEvents.rend(); ++event) {
+    if (event->type == SIM_ESPNOW && event->detail.compare(0, 2, "24") == 0) return std::stoi(event->detail.substr(10, 2), nullptr, 16);
+  }
+  return -1;
+}
+
+// Offset of the first INSERT literal byte in the patch
+uint32_t firstInsertByte() {
+  uint32_t offset = HEADER_SIZE;
+  while (offset < patch.size()) {
+    uint32_t value = patch[offset + 1] | patch[offset + 2] << 8 | patch[offset + 3] << 16 | (uint32_t)patch[offset + 4] << 24;
+    if (patch[offset] == DELTA_OP_INSERT) return offset + 5;
+    offset += patch[offset] == DELTA_OP_COPY ? 9 : 5 + value;
+  }
+  return 0;
+}
+
+// Back to idle after a failed transfer
+void waitForIdle() {
+  simAdvanceUs(3100000);
+  deltaOtaLoop();
+}
+
+void setUp() { simEvents.clear(); }
+
+void tearDown() { simFlashWriteFails = false; }
+
+void test_fixtures_and_patch() {
+  TEST_ASSERT_TRUE(oldImage.size() > 50000);
+  TEST_ASSERT_TRUE(newImage.size() > 50000);
+  TEST_ASSERT_TRUE(oldImage != newImage);
+  TEST_ASSERT_TRUE(patch.size() > HEADER_SIZE);
+  TEST_ASSERT_TRUE(patch.size() < newImage.size() / 2);
+
+  char message[120];
+  snprintf(message, sizeof(message), "old %u bytes, new %u bytes, patch %u bytes (%u chunks)", (unsigned)oldImage.size(),
+           (unsigned)newImage.size(), (unsigned)patch.size(), (unsigned)chunkCount());
+  TEST_MESSAGE(message);
+}
+
+// Nothing is requested or written before the user confirms, and the offer expires with the seeder
+void test_offer_waits_for_confirmation() {
+  sendOffer(patch);
+  TEST_ASSERT_EQUAL(DELTA_OTA_OFFERED, deltaOtaState());
+  sendChunk(0, patch);
+  TEST_ASSERT_EQUAL(0, sentToSeeder());
+  TEST_ASSERT_EQUAL(0, simCountEvents(SIM_ESPNOW));
+
+  simAdvanceUs(4000000);
+  sendOffer(patch);  // Repeated offers keep it pending
+  simAdvanceUs(4000000);
+  deltaOtaLoop();
+  TEST_ASSERT_EQUAL(DELTA_OTA_OFFERED, deltaOtaState());
+  simAdvanceUs(1100000);
+  deltaOtaLoop();
+  TEST_ASSERT_EQUAL(DELTA_OTA_IDLE, deltaOtaState());
+  TEST_ASSERT_FALSE(deltaOtaAccept());
+}
+
+void test_patch_signed_with_another_key_is_ignored() {
+  sendOffer(otherKeyPatch);
+  TEST_ASSERT_EQUAL(DELTA_OTA_IDLE, deltaOtaState());
+}
+
+// The signature covers both image hashes: a seeder cannot swap in another image
+void test_tampered_header_is_ignored() {
+  std::vector<uint8_t> tampered = patch;
+  tampered[48 + 31] ^= 0x01;  // Last byte of newSha256
+  sendOffer(tampered);
+  TEST_ASSERT_EQUAL(DELTA_OTA_IDLE, deltaOtaState());
+}
+
+void test_no_key_no_update() {
+  uint8_t key[32];
+  memcpy(key, deltaOtaKey, sizeof(key));
+  memset(deltaOtaKey, 0, sizeof(deltaOtaKey));
+  sendOffer(patch);
+  memcpy(deltaOtaKey, key, sizeof(key));
+  TEST_ASSERT_EQUAL(DELTA_OTA_IDLE, deltaOtaState());
+}
+
+// A chunk that cannot be stored is not acknowledged: the session ends and the seeder is told
+void test_flash_write_failure_aborts_and_nacks() {
+  offerAndAccept();
+  for (uint32_t i = 0; i < 3; i++) sendChunk(i, patch);
+
+  simFlashWriteFails = true;
+  sendChunk(3, patch);
+  simFlashWriteFails = false;
+  TEST_ASSERT_EQUAL(DELTA_OTA_FAILED, deltaOtaState());
+  TEST_ASSERT_EQUAL(2, lastDoneStatus());  // OTA_STATUS_WRITE_FAILED
+  TEST_ASSERT_EQUAL(esp_ota_get_running_partition(), simBootPartition);
+
+  size_t sent = simEvents.size();
+  sendChunk(4, patch);  // Ignored once aborted
+  TEST_ASSERT_EQUAL(sent, simEvents.size());
+  waitForIdle();
+  TEST_ASSERT_EQUAL(DELTA_OTA_IDLE, deltaOtaState());
+}
+
+void test_corrupted_literal_fails_verification() {
+  std::vector<uint8_t> corrupted = patch;
+  corrupted[firstInsertByte()] ^= 0x01;
+
+  offerAndAccept();
+  for (uint32_t i = 0; i < chunkCount(); i++) sendChunk(i, corrupted);
+  TEST_ASSERT_EQUAL(DELTA_OTA_FAILED, deltaOtaState());
+  TEST_ASSERT_EQUAL(1, lastDoneStatus());  // OTA_STATUS_VERIFY_FAILED
+  TEST_ASSERT_EQUAL(esp_ota_get_running_partition(), simBootPartition);
+  waitForIdle();
+}
+
+// Last: the receiver reboots into the new image afterwards
+void test_patch_applies_to_real_images() {
+  offerAndAccept();
+  for (uint32_t i = 0; i < chunkCount(); i++) sendChunk(i, patch);
+  TEST_ASSERT_EQUAL(DELTA_OTA_DONE, deltaOtaState());
+  TEST_ASSERT_EQUAL(0, lastDoneStatus());
+
+  const esp_partition_t *updated = esp_ota_get_next_update_partition(nullptr);
+  TEST_ASSERT_EQUAL(updated, simBootPartition);
+  std::vector<uint8_t> written(newImage.size());
+  esp_partition_read(updated, 0, written.data(), written.size());
+  TEST_ASSERT_TRUE(written == newImage);
+
+  // The patch is kept so this peer can seed the next ones
+  const esp_partition_t *patchPartition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)0x41, "patch");
+  std::vector<uint8_t> stored(patch.size());
+  esp_partition_read(patchPartition, 0, stored.data(), stored.size());
+  TEST_ASSERT_TRUE(stored == patch);
+
+  simAdvanceUs(1100000);
+  const char *stop = nullptr;
+  try {
+    deltaOtaLoop();
+  } catch (const SimStop &reason) {
+    stop = reason.reason;
+  }
+  TEST_ASSERT_NOT_NULL(stop);
+}
+
+int main() {
+  simQuiet = true;
+  oldImage = readFile(OLD_IMAGE);
+  newImage = readFile(NEW_IMAGE);
+
+  otherKeyPatch = makePatch(OTHER_KEY);
+  patch = makePatch(KEY);
+  if (patch.size() >= HEADER_SIZE) session = patch[48] | patch[49] << 8 | patch[50] << 16 | (uint32_t)patch[51] << 24;
+  for (int i = 0; i < 32; i++) deltaOtaKey[i] = std::stoi(std::string(KEY + 2 * i, 2), nullptr, 16);
+
+  // The running image is the old one, the radio is on
+  const esp_partition_t *running = esp_ota_get_running_partition();
+  esp_partition_erase_range(running, 0, running->size);
+  esp_partition_write(running, 0, oldImage.data(), oldImage.size());
+  WiFi.mode(WIFI_STA);
+  esp_now_init();
+  deltaOtaInit();  // Finds the partitions and starts listening
+
+  UNITY_BEGIN();
+  RUN_TEST(test_fixtures_and_patch);
+  if (patch.size() >= HEADER_SIZE && otherKeyPatch.size() >= HEADER_SIZE) {
+    RUN_TEST(test_offer_waits_for_confirmation);
+    RUN_TEST(test_patch_signed_with_another_key_is_ignored);
+    RUN_TEST(test_tampered_header_is_ignored);
+    RUN_TEST(test_no_key_no_update);
+    RUN_TEST(test_flash_write_failure_aborts_and_nacks);
+    RUN_TEST(test_corrupted_literal_fails_verification);
+    RUN_TEST(test_patch_applies_to_real_images);
+  }
+  return UNITY_END();
+}
@@ -0,0 +1,160 @@
+// Remote (src/ESPNOW.cpp) and receiver (receiver/switch_receiver.cpp) over the simulated ESP-NOW link:
+// SET, REQUEST and PUSH end to end (pio test -e sim -f test_espnow_loopback)
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <unity.h>
+
+#include "ESPNOW.h"
+#include "espnow_message.h"
+#include "settings.h"
+#include "sim.h"
+#include "switch_receiver.h"
+
+const uint8_t OTHER_REMOTE_MAC[6] = {0x24, 0x6F, 0x28, 0x0A, 0x0B, 0x0C};
+const uint8_t RELAY_PINS[4] = {16, 17, 18, 19};  // receiver/switch_receiver.cpp
+const uint32_t RELAY_TASK_WAKEUP_US = 40;        // Receive callback to relay task
+
+// The receiver: receive callback, then the relay task it wakes up
+void receiverPeer(const uint8_t *mac, const uint8_t *data, int length) {
+  uint32_t notify = receiverHandlePacket(mac, data, length);
+  if (notify == 0) return;
+  simAdvanceUs(RELAY_TASK_WAKEUP_US);
+  receiverProcess(notify);
+}
+
+// Power-on of the receiver with these outputs saved in NVS
+void bootReceiver(uint8_t savedOutputs) {
+  Preferences nvs;
+  nvs.begin("receiver");
+  nvs.putUChar("outputs", savedOutputs);
+  receiverBegin();
+}
+
+uint8_t savedOutputs() {
+  Preferences nvs;
+  nvs.begin("receiver");
+  return nvs.getUChar("outputs", 0xFF);
+}
+
+uint8_t remoteSwitchBits() {
+  uint8_t bits = 0;
+  for (int i = 0; i < 4; i++) bits |= getSwitchState(i) << i;
+  return bits;
+}
+
+void sendFromOtherRemote(uint8_t bits) {
+  struct_message message = {MSG_SWITCH_SET, {}};
+  for (int i = 0; i < 4; i++) message.toggleSwitch[i] = (bits >> i) & 1;
+  simEspNowPeerReceive(OTHER_REMOTE_MAC, (const uint8_t *)&message, sizeof(message));
+}
+
+void setUp() {
+  simEspNowPeer = receiverPeer;
+  espNowUnsubscribe();
+  for (int i = 0; i < 4; i++) restoreSwitchState(i, false);
+  espNowPoll();
+  bootReceiver(0);
+}
+
+void tearDown() {}
+
+void test_set_drives_the_relays() {
+  setSwitchState(1, true);
+  setSwitchState(3, true);
+  TEST_ASSERT_EQUAL_HEX8(0x0A, receiverOutputs());
+  for (int i = 0; i < 4; i++) TEST_ASSERT_EQUAL(i == 1 || i == 3 ? HIGH : LOW, simPinOutput[RELAY_PINS[i]]);
+
+  ReceiverLatency latency = receiverLatency();
+  TEST_ASSERT_EQUAL(RELAY_TASK_WAKEUP_US, latency.max);
+}
+
+// The remote learns the receiver state on boot and when it subscribes
+void test_startup_request_returns_receiver_state() {
+  bootReceiver(0x09);
+  dataUpdateOnStartup();
+  TEST_ASSERT_EQUAL_HEX8(0x09, remoteSwitchBits());
+  TEST_ASSERT_EQUAL_STRING("Switch 1: ON", switchLabel[0]);
+  TEST_ASSERT_EQUAL_STRING("Switch 2: OFF", switchLabel[1]);
+}
+
+// On boot the journal's states are restored first; a different state from the receiver is saved
+void test_startup_state_is_saved_after_journal_restore() {
+  loadSettings();
+  flushSettings();  // Nothing pending from the previous tests
+  restoreSwitchState(0, true);  // A saved state, restored by loadSettings() without an espNowPoll() after it
+  bootReceiver(0x06);
+  dataUpdateOnStartup();
+  flushSettings();
+
+  for (int i = 0; i < 4; i++) restoreSwitchState(i, false);
+  loadSettings();
+  TEST_ASSERT_EQUAL_HEX8(0x06, remoteSwitchBits());
+}
+
+void test_subscribe_request_returns_receiver_state() {
+  bootReceiver(0x06);
+  espNowSubscribe();
+  TEST_ASSERT_TRUE(espNowPoll());
+  TEST_ASSERT_EQUAL_HEX8(0x06, remoteSwitchBits());
+}
+
+// A change made from another remote is pushed unprompted to the subscribed remote
+void test_push_reaches_subscribed_remote() {
+  espNowSubscribe();
+  espNowPoll();
+  sendFromOtherRemote(0x0C);
+  TEST_ASSERT_TRUE(espNowPoll());
+  TEST_ASSERT_EQUAL_HEX8(0x0C, remoteSwitchBits());
+  TEST_ASSERT_EQUAL_STRING("Switch 3: ON", switchLabel[2]);
+}
+
+void test_push_is_missed_with_radio_off() {
+  espNowSubscribe();
+  espNowUnsubscribe();
+  sendFromOtherRemote(0x01);
+  TEST_ASSERT_FALSE(espNowPoll());
+  TEST_ASSERT_EQUAL_HEX8(0x00, remoteSwitchBits());
+}
+
+// Bursts are written to NVS once, after 2 s without changes, and restored on the next boot
+void test_outputs_saved_after_quiet_period() {
+  setSwitchState(0, true);
+  setSwitchState(2, true);
+  receiverProcess(0);
+  TEST_ASSERT_EQUAL_HEX8(0x00, savedOutputs());
+
+  simAdvanceUs(RECEIVER_SAVE_DELAY * 1000);
+  TEST_ASSERT_TRUE(receiverSavePending());
+  receiverProcess(0);  // Relay task wait timed out
+  TEST_ASSERT_FALSE(receiverSavePending());
+  TEST_ASSERT_EQUAL_HEX8(0x05, savedOutputs());
+
+  receiverBegin();
+  TEST_ASSERT_EQUAL_HEX8(0x05, receiverOutputs());
+  TEST_ASSERT_EQUAL(HIGH, simPinOutput[RELAY_PINS[2]]);
+}
+
+void test_malformed_packets_are_ignored() {
+  struct_message message = {MSG_SWITCH_SET, {true, true, true, true}};
+  TEST_ASSERT_EQUAL(0, receiverHandlePacket(OTHER_REMOTE_MAC, (const uint8_t *)&message, sizeof(message) - 1));
+  message.type = MSG_STATE_PUSH;  // Only receivers push
+  TEST_ASSERT_EQUAL(0, receiverHandlePacket(OTHER_REMOTE_MAC, (const uint8_t *)&message, sizeof(message)));
+  message.type = 7;
+  TEST_ASSERT_EQUAL(0, receiverHandlePacket(OTHER_REMOTE_MAC, (const uint8_t *)&message, sizeof(message)));
+  TEST_ASSERT_EQUAL_HEX8(0x00, receiverOutputs());
+}
+
+int main() {
+  simQuiet = true;
+  UNITY_BEGIN();
+  RUN_TEST(test_set_drives_the_relays);
+  RUN_TEST(test_startup_request_returns_receiver_state);
+  RUN_TEST(test_startup_state_is_saved_after_journal_restore);
+  RUN_TEST(test_subscribe_request_returns_receiver_state);
+  RUN_TEST(test_push_reaches_subscribed_remote);
+  RUN_TEST(test_push_is_missed_with_radio_off);
+  RUN_TEST(test_outputs_saved_after_quiet_period);
+  RUN_TEST(test_malformed_packets_are_ignored);
+  return UNITY_END();
+}
@@ -0,0 +1,123 @@
+// Multi-emitter RMT scheduling against the simulated RMT (pio test -e sim -f test_ir_emitter)
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "ir_emitter.h"
+#include "ir_general.h"
+#include "sim.h"
+
+const uint8_t SHARP_STATE[IR_STATE_MAX_BYTES] = {0xAA, 0x5A, 0xCF, 0x10, 0x00, 0x01, 0x00, 0x08, 0x80, 0x00, 0xF0, 0x01, 0x91};
+
+std::vector<uint32_t> renderedTimings(const IrCommand &command) {
+  uint32_t timings[IR_MAX_TIMINGS];
+  uint32_t frequency;
+  uint8_t dutyCycle;
+  uint16_t count = irRenderTimings(command, timings, IR_MAX_TIMINGS, frequency, dutyCycle);
+  return std::vector<uint32_t>(timings, timings + count);
+}
+
+const SimRmtFrame *frameOnChannel(uint8_t channel) {
+  for (const SimRmtFrame &frame : simRmtFrames) {
+    if (frame.channel == channel) return &frame;
+  }
+  return nullptr;
+}
+
+void setUp() {
+  irFlush();
+  simRmtFrames.clear();
+  irCarrierEnabled = true;
+}
+
+void tearDown() {}
+
+void test_every_emitter_has_its_own_pin() {
+  for (uint8_t appliance = 0; appliance < IR_APPLIANCE_COUNT; appliance++) {
+    irEmit((IrAppliance)appliance, irCodeCommand(IR_PROTOCOL_NEC, tvLGPowerToggle, 32));
+    TEST_ASSERT_EQUAL(irApplianceEmitter[appliance], simRmtFrames.back().channel);
+  }
+  TEST_ASSERT_EQUAL(IR_LED, frameOnChannel(0)->pin);
+  for (uint8_t i = 0; i < IR_EMITTER_COUNT; i++) {
+    TEST_ASSERT_NOT_NULL_MESSAGE(frameOnChannel(i), "No appliance mapped to an emitter");
+    for (uint8_t j = 0; j < i; j++) TEST_ASSERT_NOT_EQUAL(frameOnChannel(j)->pin, frameOnChannel(i)->pin);
+  }
+}
+
+void test_power_off_all_runs_in_parallel() {
+  uint64_t startUs = simNowUs();
+  irPowerOffAll();
+  uint64_t elapsedUs = simNowUs() - startUs;
+
+  TEST_ASSERT_EQUAL(3, simRmtFrames.size());
+  uint64_t longestUs = 0;
+  uint64_t sumUs = 0;
+  for (const SimRmtFrame &frame : simRmtFrames) {
+    TEST_ASSERT_EQUAL(startUs, frame.startUs);  // All three start at once
+    longestUs = max(longestUs, frame.endUs - frame.startUs);
+    sumUs += frame.endUs - frame.startUs;
+  }
+  char message[96];
+  snprintf(message, sizeof(message), "Power Off All: %lu ms on the air, %lu ms one after another", (unsigned long)(elapsedUs / 1000), (unsigned long)(sumUs / 1000));
+  TEST_MESSAGE(message);
+  TEST_ASSERT_GREATER_OR_EQUAL(longestUs, elapsedUs);
+  TEST_ASSERT_LESS_THAN(longestUs + 2000, elapsedUs);  // irFlush() polls every millisecond
+}
+
+void test_same_emitter_frames_go_one_after_another() {
+  TEST_ASSERT_EQUAL(irApplianceEmitter[IR_LG_TV], irApplianceEmitter[IR_ASTRO]);
+  irQueue(IR_LG_TV, irCodeCommand(IR_PROTOCOL_NEC, tvLGPowerToggle, 32));
+  irQueue(IR_ASTRO, irCodeCommand(IR_PROTOCOL_RC6, tvAstroPowerToggle.code, 36));
+  irFlush();
+
+  TEST_ASSERT_EQUAL(2, simRmtFrames.size());
+  TEST_ASSERT_GREATER_OR_EQUAL(simRmtFrames[0].endUs, simRmtFrames[1].startUs);
+}
+
+// Frames sent at the same time on other channels do not change what each LED transmits
+void test_parallel_frames_keep_their_timings() {
+  IrCommand sharp = irStateCommand(IR_PROTOCOL_SHARP_AC, SHARP_STATE, IR_STATE_MAX_BYTES);
+  IrCommand daikin = irCodeCommand(IR_PROTOCOL_DAIKIN64, 0x7C16161607204216, 64);
+  IrCommand deka = irCodeCommand(IR_PROTOCOL_SYMPHONY, fanDekaPowerOff, 12, 1);
+  irQueue(IR_SHARP_AC, sharp);
+  irQueue(IR_DAIKIN_AC, daikin);
+  irQueue(IR_DEKA_FAN, deka);
+  irFlush();
+
+  TEST_ASSERT_EQUAL(3, simRmtFrames.size());
+  TEST_ASSERT_TRUE(renderedTimings(sharp) == frameOnChannel(irApplianceEmitter[IR_SHARP_AC])->timings);
+  TEST_ASSERT_TRUE(renderedTimings(daikin) == frameOnChannel(irApplianceEmitter[IR_DAIKIN_AC])->timings);
+  TEST_ASSERT_TRUE(renderedTimings(deka) == frameOnChannel(irApplianceEmitter[IR_DEKA_FAN])->timings);
+}
+
+void test_full_emitter_queue_rejects_commands() {
+  IrCommand command = irCodeCommand(IR_PROTOCOL_NEC, tvLGVolumeUp, 32);
+  uint8_t accepted = 0;
+  while (irQueue(IR_LG_TV, command)) accepted++;
+  TEST_ASSERT_EQUAL(4, accepted);
+  TEST_ASSERT_TRUE(irQueue(IR_DEKA_FAN, irCodeCommand(IR_PROTOCOL_SYMPHONY, fanDekaPowerOff, 12)));  // Other emitters still accept
+  irFlush();
+  TEST_ASSERT_EQUAL(5, simRmtFrames.size());
+}
+
+void test_carrier_off_for_loopback() {
+  irCarrierEnabled = false;
+  irEmit(IR_LG_TV, irCodeCommand(IR_PROTOCOL_NEC, tvLGVolumeDown, 32));
+  TEST_ASSERT_FALSE(simRmtFrames.back().carrier);
+
+  irCarrierEnabled = true;
+  irEmit(IR_LG_TV, irCodeCommand(IR_PROTOCOL_NEC, tvLGVolumeDown, 32));
+  TEST_ASSERT_TRUE(simRmtFrames.back().carrier);
+}
+
+int main() {
+  simQuiet = true;
+  UNITY_BEGIN();
+  RUN_TEST(test_every_emitter_has_its_own_pin);
+  RUN_TEST(test_power_off_all_runs_in_parallel);
+  RUN_TEST(test_same_emitter_frames_go_one_after_another);
+  RUN_TEST(test_parallel_frames_keep_their_timings);
+  RUN_TEST(test_full_emitter_queue_rejects_commands);
+  RUN_TEST(test_carrier_off_for_loopback);
+  return UNITY_END();
+}
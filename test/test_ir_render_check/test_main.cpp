@@ -0,0 +1,87 @@
+// IR render check: every send path against the golden protocol timings (pio test -e sim -f test_ir_render_check)
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "ir_general.h"
+#include "ir_render_check.h"
+#include "sim.h"
+
+IrCheckBuffers buffers;
+CapturedCommand necEntry = {"LG TV Power", IR_LG_TV, irCodeCommand(IR_PROTOCOL_NEC, tvLGPowerToggle, 32)};
+
+void setUp() { simRmtFrames.clear(); }
+
+void tearDown() {}
+
+void test_every_send_path_matches_golden() {
+  captureSendPaths(buffers);
+  TEST_ASSERT_EQUAL(8, buffers.capturedCount);
+  TEST_ASSERT_EQUAL(0, simRmtFrames.size());  // Captured commands never reach the RMT
+  TEST_ASSERT_EQUAL(0, runRenderCheck(buffers));
+}
+
+void test_capture_restores_the_previous_hook() {
+  IrCaptureHook hook = irCaptureHook;
+  captureSendPaths(buffers);
+  TEST_ASSERT_TRUE(irCaptureHook == hook);
+}
+
+// The check must fail on a pulse out of tolerance, not just run
+void test_drift_out_of_tolerance_fails() {
+  buildGolden(necEntry.command, buffers.golden);
+  renderSequence(necEntry.command, buffers.rendered);
+  TEST_ASSERT_TRUE(comparePulses("test", necEntry, buffers.golden, buffers.rendered, nullptr));
+
+  buffers.rendered.duration[0] = buffers.golden.duration[0] * 120 / 100;  // Header mark +20%
+  TEST_ASSERT_TRUE(comparePulses("test", necEntry, buffers.golden, buffers.rendered, nullptr));
+  buffers.rendered.duration[0] = buffers.golden.duration[0] * 130 / 100;  // +30%
+  TEST_ASSERT_FALSE(comparePulses("test", necEntry, buffers.golden, buffers.rendered, nullptr));
+}
+
+void test_missing_pulse_fails() {
+  buildGolden(necEntry.command, buffers.golden);
+  renderSequence(necEntry.command, buffers.rendered);
+  buffers.rendered.count -= 2;
+  TEST_ASSERT_FALSE(comparePulses("test", necEntry, buffers.golden, buffers.rendered, nullptr));
+}
+
+// Gaps only have a minimum length
+void test_gap_may_be_longer_but_not_shorter() {
+  buildGolden(necEntry.command, buffers.golden);
+  renderSequence(necEntry.command, buffers.rendered);
+  uint16_t gap = buffers.golden.count - 1;
+  TEST_ASSERT_TRUE(buffers.golden.gap[gap]);
+
+  buffers.rendered.duration[gap] = buffers.golden.duration[gap] * 3;
+  TEST_ASSERT_TRUE(comparePulses("test", necEntry, buffers.golden, buffers.rendered, nullptr));
+  buffers.rendered.duration[gap] = buffers.golden.duration[gap] / 2;
+  TEST_ASSERT_FALSE(comparePulses("test", necEntry, buffers.golden, buffers.rendered, nullptr));
+}
+
+// What the loopback check compares: both sides split into RX captures at the same places
+void test_split_at_idle_keeps_golden_and_rendered_aligned() {
+  captureSendPaths(buffers);
+  for (uint8_t i = 0; i < buffers.capturedCount; i++) {
+    const CapturedCommand &entry = buffers.captured[i];
+    buildGolden(entry.command, buffers.golden);
+    renderSequence(entry.command, buffers.rendered);
+    splitAtIdle(buffers.golden, &buffers.rendered);
+    splitAtIdle(buffers.rendered);
+    TEST_ASSERT_TRUE_MESSAGE(comparePulses("split", entry, buffers.golden, buffers.rendered, nullptr), entry.label);
+    TEST_ASSERT_EQUAL(1, buffers.rendered.count % 2);  // Every capture ends with a mark
+  }
+}
+
+int main() {
+  simQuiet = true;
+  simInstallIrCapture();
+  UNITY_BEGIN();
+  RUN_TEST(test_every_send_path_matches_golden);
+  RUN_TEST(test_capture_restores_the_previous_hook);
+  RUN_TEST(test_drift_out_of_tolerance_fails);
+  RUN_TEST(test_missing_pulse_fails);
+  RUN_TEST(test_gap_may_be_longer_but_not_shorter);
+  RUN_TEST(test_split_at_idle_keeps_golden_and_rendered_aligned);
+  return UNITY_END();
+}
@@ -0,0 +1,104 @@
+// Render cache: cached strings are pixel-identical to u8g2.drawStr() (pio test -e sim -f test_render_cache)
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <chrono>
+
+#include "render_cache.h"
+#include "sim.h"
+
+const uint8_t *const FONTS[] = {u8g2_font_spleen8x16_mr, u8g2_font_spleen6x12_mr, u8g2_font_minuteconsole_mr, u8g2_font_profont29_tr};
+const char *const TEXTS[] = {"MAIN MENU", "Home Automation", "v1.92.00", "23", "Swing:"};
+
+uint8_t expected[128 * 8];
+
+typedef void (*DrawStr)(int x, int y, const char *text);
+void plainDrawStr(int x, int y, const char *text) { u8g2.drawStr(x, y, text); }
+
+// Background with set and cleared pixels so transparent drawing and every draw color show
+void drawBackground() {
+  u8g2.clearBuffer();
+  u8g2.setDrawColor(1);
+  u8g2.drawBox(20, 0, 40, 64);
+  u8g2.drawHLine(0, 12, 128);
+}
+
+void drawWith(DrawStr draw, const uint8_t *font, uint8_t color, int x, int y, const char *text) {
+  drawBackground();
+  u8g2.setFont(font);
+  u8g2.setDrawColor(color);
+  draw(x, y, text);
+}
+
+// The menu frame of drawMenu(): header, three rows with the highlight box and the footer
+void drawMenuFrame(DrawStr draw, int firstRow) {
+  u8g2.clearBuffer();
+  u8g2.setDrawColor(1);
+  u8g2.setFont(u8g2_font_spleen8x16_mr);
+  draw(28, 10, "IR REMOTE");
+  u8g2.drawHLine(0, 12, 128);
+  u8g2.setFont(u8g2_font_spleen6x12_mr);
+  const char *const rows[] = {"Deka Fan", "Sharp A/C", "Daikin A/C", "LG TV", "Astro"};
+  for (int i = 0; i < 3; i++) draw(1, i * 12 + 25, rows[(firstRow + i) % 5]);
+  u8g2.setDrawColor(2);
+  u8g2.drawBox(0, 15, 128, 12);
+  u8g2.setDrawColor(1);
+  u8g2.drawHLine(0, 54, 128);
+  u8g2.setFont(u8g2_font_minuteconsole_mr);
+  draw(88, 63, "v1.92.00");
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_cached_strings_match_draw_str() {
+  for (const uint8_t *font : FONTS) {
+    for (const char *text : TEXTS) {
+      for (uint8_t color = 0; color <= 2; color++) {
+        for (int y = -4; y < 72; y += 3) {  // Every bit offset within a page, partly off screen at both ends
+          for (int x : {-5, 0, 1, 50, 110}) {
+            drawWith(plainDrawStr, font, color, x, y, text);
+            memcpy(expected, u8g2.getBufferPtr(), sizeof(expected));
+            drawWith(cachedDrawStr, font, color, x, y, text);  // Miss on the first pass, hit after that
+            TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected, u8g2.getBufferPtr(), sizeof(expected), text);
+            drawWith(cachedDrawStr, font, color, x, y, text);
+            TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected, u8g2.getBufferPtr(), sizeof(expected), text);
+          }
+        }
+      }
+    }
+  }
+}
+
+// Host time per menu frame with and without the cache. Placeholder glyphs are drawn pixel by pixel
+// like U8g2 decodes glyphs, so this shows the trend; the device number is frameAvgUs of "metrics".
+void test_menu_frame_render_time() {
+  const int frames = 20000;
+  double averageUs[2];
+  DrawStr draws[2] = {plainDrawStr, cachedDrawStr};
+
+  for (int mode = 0; mode < 2; mode++) {
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++) drawMenuFrame(draws[mode], frame / 500);  // Scrolls every 500 frames
+    averageUs[mode] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+  }
+
+  drawMenuFrame(plainDrawStr, 0);
+  memcpy(expected, u8g2.getBufferPtr(), sizeof(expected));
+  drawMenuFrame(cachedDrawStr, 0);
+  TEST_ASSERT_EQUAL_MEMORY(expected, u8g2.getBufferPtr(), sizeof(expected));
+
+  char message[96];
+  snprintf(message, sizeof(message), "Menu frame on the host: %.2f us with drawStr(), %.2f us with the render cache", averageUs[0], averageUs[1]);
+  TEST_MESSAGE(message);
+}
+
+int main() {
+  simQuiet = true;
+  UNITY_BEGIN();
+  RUN_TEST(test_cached_strings_match_draw_str);
+  RUN_TEST(test_menu_frame_render_time);
+  return UNITY_END();
+}
@@ -0,0 +1,131 @@
+// Job queue ordering and deep-sleep wake-up scheduling (pio test -e sim -f test_scheduler)
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "scheduler.h"
+#include "sim.h"
+
+// IR frames recorded since setUp(), as a string of appliance initials ("dsd" = Daikin, Sharp, Daikin)
+std::string irSequence() {
+  std::string sequence;
+  for (const SimEvent &event : simEvents) {
+    if (event.type == SIM_IR) sequence += event.detail[0];
+  }
+  return sequence;
+}
+
+void advanceSeconds(uint32_t seconds) { simAdvanceUs((uint64_t)seconds * 1000000); }
+
+void setUp() {
+  cancelScheduledJobs();
+  simEvents.clear();
+  simSleepTimerUs = 0;
+  simWakeupCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+}
+
+void tearDown() {}
+
+void test_jobs_run_in_due_order() {
+  scheduleJob(SCHEDULE_DAIKIN_AC_POWER_TOGGLE, 0, 300);
+  scheduleJob(SCHEDULE_SHARP_AC_OFF, 0, 200);
+  scheduleJob(SCHEDULE_DAIKIN_AC_POWER_TOGGLE, 0, 100);
+  advanceSeconds(301);
+  runDueJobs();
+  TEST_ASSERT_EQUAL_STRING("dsd", irSequence().c_str());
+  TEST_ASSERT_EQUAL(0, scheduledJobCount());
+}
+
+void test_equal_due_times_keep_schedule_order() {
+  scheduleJob(SCHEDULE_SHARP_AC_OFF, 0, 60);
+  scheduleJob(SCHEDULE_DAIKIN_AC_POWER_TOGGLE, 0, 60);
+  scheduleJob(SCHEDULE_SHARP_AC_OFF, 0, 60);
+  advanceSeconds(60);
+  runDueJobs();
+  TEST_ASSERT_EQUAL_STRING("sds", irSequence().c_str());
+}
+
+void test_only_due_jobs_run() {
+  scheduleJob(SCHEDULE_DAIKIN_AC_POWER_TOGGLE, 0, 500);
+  scheduleJob(SCHEDULE_SHARP_AC_OFF, 0, 100);
+  advanceSeconds(99);
+  runDueJobs();
+  TEST_ASSERT_EQUAL_STRING("", irSequence().c_str());
+
+  advanceSeconds(1);
+  runDueJobs();
+  TEST_ASSERT_EQUAL_STRING("s", irSequence().c_str());
+  TEST_ASSERT_EQUAL(1, scheduledJobCount());
+}
+
+void test_full_queue_rejects_jobs() {
+  for (uint8_t i = 0; i < MAX_SCHEDULED_JOBS; i++) TEST_ASSERT_TRUE(scheduleJob(SCHEDULE_SHARP_AC_OFF, 0, 100 + i));
+  TEST_ASSERT_FALSE(scheduleJob(SCHEDULE_SHARP_AC_OFF, 0, 50));
+  TEST_ASSERT_EQUAL(MAX_SCHEDULED_JOBS, scheduledJobCount());
+}
+
+void test_wakeup_armed_for_earliest_job() {
+  scheduleJob(SCHEDULE_SHARP_AC_OFF, 0, 5400);
+  scheduleJob(SCHEDULE_DAIKIN_AC_POWER_TOGGLE, 0, 1800);
+  advanceSeconds(600);
+  armSchedulerWakeup();
+  TEST_ASSERT_EQUAL_UINT64(1200ULL * 1000000 + 1000, simSleepTimerUs);  // 1 ms past the due time
+}
+
+void test_overdue_job_wakes_immediately() {
+  scheduleJob(SCHEDULE_SHARP_AC_OFF, 0, 10);
+  advanceSeconds(20);
+  armSchedulerWakeup();
+  TEST_ASSERT_EQUAL_UINT64(1000, simSleepTimerUs);
+}
+
+void test_no_wakeup_without_jobs() {
+  armSchedulerWakeup();
+  TEST_ASSERT_EQUAL_UINT64(0, simSleepTimerUs);
+}
+
+// Timer wake-up: run the due job without UI, re-arm for the next one and sleep again
+void test_headless_wakeup() {
+  scheduleJob(SCHEDULE_DAIKIN_AC_POWER_TOGGLE, 0, 1800);
+  scheduleJob(SCHEDULE_SHARP_AC_OFF, 0, 5400);
+  advanceSeconds(1800);
+  simWakeupCause = ESP_SLEEP_WAKEUP_TIMER;
+  TEST_ASSERT_TRUE(isSchedulerWakeup());
+
+  uint64_t wakeUs = simNowUs();
+  bool slept = false;
+  try {
+    runHeadlessWakeup();
+  } catch (const SimStop &) {
+    slept = true;
+  }
+  TEST_ASSERT_TRUE(slept);
+  TEST_ASSERT_EQUAL_STRING("d", irSequence().c_str());
+  TEST_ASSERT_EQUAL(1, scheduledJobCount());
+  TEST_ASSERT_UINT32_WITHIN(1000000, 3600ULL * 1000000, simSleepTimerUs);
+
+  // Awake time is the IR frame on the air (Daikin64 with its message gap: ~215 ms) plus a few ms of work
+  const SimEvent &frame = simEvents[0];
+  uint32_t startMs = (frame.timeUs - wakeUs) / 1000;
+  uint32_t awakeMs = (simNowUs() - wakeUs) / 1000;
+  char message[80];
+  snprintf(message, sizeof(message), "Headless wake-up: frame after %lu ms, asleep after %lu ms", (unsigned long)startMs, (unsigned long)awakeMs);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_LESS_OR_EQUAL(10, startMs);
+  TEST_ASSERT_LESS_OR_EQUAL(250, awakeMs);
+}
+
+int main() {
+  simQuiet = true;
+  simInstallIrCapture();
+  UNITY_BEGIN();
+  RUN_TEST(test_jobs_run_in_due_order);
+  RUN_TEST(test_equal_due_times_keep_schedule_order);
+  RUN_TEST(test_only_due_jobs_run);
+  RUN_TEST(test_full_queue_rejects_jobs);
+  RUN_TEST(test_wakeup_armed_for_earliest_job);
+  RUN_TEST(test_overdue_job_wakes_immediately);
+  RUN_TEST(test_no_wakeup_without_jobs);
+  RUN_TEST(test_headless_wakeup);
+  return UNITY_END();
+}
@@ -0,0 +1,120 @@
+// Serial command pipeline: loop() never waits for the radio (pio test -e sim -f test_serial_command)
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "ESPNOW.h"
+#include "serial_command.h"
+#include "sim.h"
+
+const uint64_t LOOP_US = 1000;  // Virtual time between two loop() passes
+
+// One loop() pass of the serial pipeline. Returns the virtual time it took (0 when nothing waited).
+uint64_t serialLoopPass() {
+  uint64_t startUs = simNowUs();
+  serialCommandLoop();
+  espNowPoll();
+  return simNowUs() - startUs;
+}
+
+const SimEvent *findReply(const char *id) {
+  std::string prefix = std::string(id) + " ";
+  for (const SimEvent &event : simEvents) {
+    if (event.type == SIM_SERIAL_OUT && event.detail.compare(0, prefix.size(), prefix) == 0) return &event;
+  }
+  return nullptr;
+}
+
+// Runs loop passes until the response to id arrives or timeoutMs passes. Returns the longest pass.
+uint64_t runUntilReply(const char *id, uint32_t timeoutMs = 1000) {
+  uint64_t longestUs = 0;
+  for (uint32_t i = 0; i < timeoutMs && findReply(id) == nullptr; i++) {
+    longestUs = max(longestUs, serialLoopPass());
+    simAdvanceUs(LOOP_US);
+  }
+  return longestUs;
+}
+
+void setUp() {
+  runUntilReply("-");  // Nothing left from the previous test
+  simEvents.clear();
+  simRmtFrames.clear();
+}
+
+void tearDown() {}
+
+void test_ir_command_replies_when_the_frame_is_out() {
+  simSerialInput("1 ir lg.power");
+  uint64_t startUs = simNowUs();
+  TEST_ASSERT_EQUAL(0, serialLoopPass());
+  TEST_ASSERT_NULL(findReply("1"));  // Started, not sent yet
+  TEST_ASSERT_EQUAL(1, simRmtFrames.size());
+
+  TEST_ASSERT_EQUAL(0, runUntilReply("1"));
+  const SimEvent *reply = findReply("1");
+  TEST_ASSERT_NOT_NULL(reply);
+  TEST_ASSERT_EQUAL_STRING("1 OK", reply->detail.c_str());
+  TEST_ASSERT_GREATER_OR_EQUAL(simRmtFrames[0].endUs, reply->timeUs);
+  TEST_ASSERT_LESS_THAN(simRmtFrames[0].endUs + 2 * LOOP_US, reply->timeUs);
+
+  char message[80];
+  snprintf(message, sizeof(message), "ir lg.power: OK after %lu ms, longest loop() pass 0 ms", (unsigned long)((reply->timeUs - startUs) / 1000));
+  TEST_MESSAGE(message);
+}
+
+void test_switch_command_does_not_wait() {
+  simSerialInput("2 switch 1 on");
+  TEST_ASSERT_EQUAL(0, serialLoopPass());
+  TEST_ASSERT_EQUAL(1, simCountEvents(SIM_ESPNOW));
+  TEST_ASSERT_EQUAL(0, runUntilReply("2"));
+  TEST_ASSERT_EQUAL_STRING("2 OK switch1=on", findReply("2")->detail.c_str());
+  TEST_ASSERT_FALSE(switchSendPoll());
+}
+
+// Responses keep the request order although every command only starts its transmission
+void test_pipelined_commands_reply_in_order() {
+  simSerialInput("3 ir deka.off");
+  simSerialInput("4 switch 2 toggle");
+  simSerialInput("5 ir fft.1");
+  simSerialInput("6 state");
+  TEST_ASSERT_EQUAL(0, runUntilReply("6"));
+
+  std::string order;
+  for (const SimEvent &event : simEvents) {
+    if (event.type == SIM_SERIAL_OUT && isdigit(event.detail[0])) order += event.detail[0];
+  }
+  TEST_ASSERT_EQUAL_STRING("3456", order.c_str());
+  TEST_ASSERT_EQUAL(2, simRmtFrames.size());
+  TEST_ASSERT_GREATER_OR_EQUAL(simRmtFrames[0].endUs, simRmtFrames[1].startUs);  // fft.1 started after deka.off was answered
+}
+
+// A scene sends the IR burst in parallel and answers once everything is out
+void test_scene_replies_after_the_whole_burst() {
+  simSerialInput("7 scene alloff");
+  TEST_ASSERT_EQUAL(0, serialLoopPass());
+  TEST_ASSERT_EQUAL(3, simRmtFrames.size());
+  TEST_ASSERT_EQUAL(4, simCountEvents(SIM_ESPNOW));
+
+  TEST_ASSERT_EQUAL(0, runUntilReply("7"));
+  uint64_t lastEndUs = 0;
+  for (const SimRmtFrame &frame : simRmtFrames) lastEndUs = max(lastEndUs, frame.endUs);
+  TEST_ASSERT_EQUAL_STRING("7 OK steps=5", findReply("7")->detail.c_str());
+  TEST_ASSERT_GREATER_OR_EQUAL(lastEndUs, findReply("7")->timeUs);
+}
+
+void test_errors_reply_right_away() {
+  simSerialInput("8 ir nothing");
+  TEST_ASSERT_EQUAL(0, serialLoopPass());
+  TEST_ASSERT_EQUAL_STRING("8 ERR unknown code nothing", findReply("8")->detail.c_str());
+}
+
+int main() {
+  simQuiet = true;
+  UNITY_BEGIN();
+  RUN_TEST(test_ir_command_replies_when_the_frame_is_out);
+  RUN_TEST(test_switch_command_does_not_wait);
+  RUN_TEST(test_pipelined_commands_reply_in_order);
+  RUN_TEST(test_scene_replies_after_the_whole_burst);
+  RUN_TEST(test_errors_reply_right_away);
+  return UNITY_END();
+}
@@ -0,0 +1,178 @@
+// Settings journal on a RAM-backed flash partition with power cuts injected at every byte
+// (pio test -e sim -f test_settings_journal)
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <unity.h>
+
+#include "ir_aircond.h"
+#include "settings.h"
+#include "sim.h"
+
+const uint32_t RECORD_SIZE = 32;
+const uint32_t SECTOR_SIZE = 4096;
+const uint32_t RECORDS_PER_SECTOR = SECTOR_SIZE / RECORD_SIZE;
+
+const esp_partition_t *journal() { return esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)0x40, "journal"); }
+
+uint32_t journalSectors() { return journal()->size / SECTOR_SIZE; }
+
+// Power-on: RAM holds the defaults again, then the journal is loaded
+uint8_t reboot() {
+  daikinSetTemp = 20;
+  loadSettings();
+  return daikinSetTemp;
+}
+
+void changeTemp(uint8_t temp) {
+  daikinSetTemp = temp;
+  markSettingsDirty();
+}
+
+// Flushes a change and reports whether the power was cut before it completed
+bool flushWithPowerCut(uint8_t temp, int64_t budget) {
+  changeTemp(temp);
+  simFlashBudget = budget;
+  bool cut = false;
+  try {
+    flushSettings();
+  } catch (const SimStop &) {
+    cut = true;
+  }
+  simFlashBudget = -1;
+  return cut;
+}
+
+// Temperatures 16..30 in a cycle, never the same twice in a row
+uint8_t tempForFlush(uint32_t i) { return 16 + i % 15; }
+
+void setUp() {
+  simFlashBudget = -1;
+  esp_partition_erase_range(journal(), 0, journal()->size);
+  reboot();
+  simFlashBytesWritten = 0;
+  simFlashSectorErases = 0;
+}
+
+void tearDown() {}
+
+void test_empty_journal_keeps_defaults() {
+  TEST_ASSERT_EQUAL(20, reboot());
+  TEST_ASSERT_EQUAL(0, simFlashBytesWritten);
+}
+
+void test_flush_survives_reboot() {
+  changeTemp(27);
+  flushSettings();
+  TEST_ASSERT_EQUAL(27, reboot());
+}
+
+void test_changes_are_coalesced() {
+  for (uint8_t temp = 16; temp <= 30; temp++) changeTemp(temp);
+  flushSettings();
+  TEST_ASSERT_EQUAL(RECORD_SIZE, simFlashBytesWritten);  // One record for 15 changes
+
+  changeTemp(25);
+  changeTemp(30);
+  flushSettings();
+  TEST_ASSERT_EQUAL(RECORD_SIZE, simFlashBytesWritten);  // Changes that cancel out are not written
+}
+
+void test_idle_flush_waits_for_quiet() {
+  changeTemp(24);
+  simAdvanceUs(4900000);
+  flushSettingsIfIdle();
+  TEST_ASSERT_EQUAL(0, simFlashBytesWritten);
+  simAdvanceUs(100000);
+  flushSettingsIfIdle();
+  TEST_ASSERT_EQUAL(RECORD_SIZE, simFlashBytesWritten);
+}
+
+// A cut at any byte of a record leaves either the old or (only when complete) the new state,
+// and the next flush goes after the torn slot
+void test_torn_record_at_every_byte() {
+  changeTemp(22);
+  flushSettings();
+
+  for (uint32_t cutAt = 0; cutAt <= RECORD_SIZE; cutAt++) {
+    TEST_ASSERT_EQUAL(22, reboot());
+    bool cut = flushWithPowerCut(23, cutAt);
+    TEST_ASSERT_EQUAL(cutAt < RECORD_SIZE, cut);
+    TEST_ASSERT_EQUAL(cut ? 22 : 23, reboot());
+
+    changeTemp(22);
+    flushSettings();
+  }
+  TEST_ASSERT_EQUAL(22, reboot());
+}
+
+void test_crc_mismatch_is_rejected() {
+  changeTemp(21);
+  flushSettings();
+  changeTemp(29);
+  flushSettings();
+
+  // Clear one set bit of the second record's CRC, as a bit flip in flash would
+  uint32_t crcOffset = RECORD_SIZE + RECORD_SIZE - 4;
+  uint8_t crcByte;
+  esp_partition_read(journal(), crcOffset, &crcByte, 1);
+  if (crcByte == 0) esp_partition_read(journal(), ++crcOffset, &crcByte, 1);
+  crcByte &= crcByte - 1;
+  esp_partition_write(journal(), crcOffset, &crcByte, 1);
+
+  TEST_ASSERT_EQUAL(21, reboot());
+}
+
+// Wrap around the ring: every sector is erased once per lap, loading stays O(sectors)
+void test_sector_wrap() {
+  uint32_t flushes = journalSectors() * RECORDS_PER_SECTOR + 200;
+  for (uint32_t i = 0; i < flushes; i++) {
+    changeTemp(tempForFlush(i));
+    flushSettings();
+  }
+  TEST_ASSERT_EQUAL(flushes * RECORD_SIZE, simFlashBytesWritten);
+  TEST_ASSERT_EQUAL((flushes + RECORDS_PER_SECTOR - 1) / RECORDS_PER_SECTOR, simFlashSectorErases);
+
+  simFlashReads = 0;
+  TEST_ASSERT_EQUAL(tempForFlush(flushes - 1), reboot());
+  TEST_ASSERT_LESS_OR_EQUAL(journalSectors() + 10, simFlashReads);  // First record per sector + binary search + newest record
+
+  char message[120];
+  snprintf(message, sizeof(message), "%lu flushes: %lu bytes programmed per flush, %lu bytes erased per flush, %lu reads to load",
+           (unsigned long)flushes, (unsigned long)(simFlashBytesWritten / flushes), (unsigned long)(simFlashSectorErases * SECTOR_SIZE / flushes),
+           (unsigned long)simFlashReads);
+  TEST_MESSAGE(message);
+}
+
+// The ring is full: the next flush recycles the oldest sector. A cut during that erase keeps the newest state.
+void test_power_cut_while_recycling_a_sector() {
+  uint32_t flushes = journalSectors() * RECORDS_PER_SECTOR;
+  for (uint32_t i = 0; i < flushes; i++) {
+    changeTemp(tempForFlush(i));
+    flushSettings();
+  }
+  uint8_t newest = tempForFlush(flushes - 1);
+
+  for (int64_t cutAt : {0L, 1L, 2048L, 4095L}) {
+    TEST_ASSERT_TRUE(flushWithPowerCut(newest == 30 ? 16 : newest + 1, cutAt));
+    TEST_ASSERT_EQUAL(newest, reboot());
+  }
+
+  changeTemp(newest == 30 ? 16 : newest + 1);
+  flushSettings();
+  TEST_ASSERT_EQUAL(newest == 30 ? 16 : newest + 1, reboot());
+}
+
+int main() {
+  simQuiet = true;
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_journal_keeps_defaults);
+  RUN_TEST(test_flush_survives_reboot);
+  RUN_TEST(test_changes_are_coalesced);
+  RUN_TEST(test_idle_flush_waits_for_quiet);
+  RUN_TEST(test_torn_record_at_every_byte);
+  RUN_TEST(test_crc_mismatch_is_rejected);
+  RUN_TEST(test_sector_wrap);
+  RUN_TEST(test_power_cut_while_recycling_a_sector);
+  return UNITY_END();
+}
@@ -0,0 +1,161 @@
+// WebSocket client against the stand-in server of the simulator: pipelining, ordering, timeouts and latency
+// (pio test -e sim -f test_websocket_client)
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <unity.h>
+
+#include "ESPNOW.h"
+#include "sim.h"
+#include "websocket_client.h"
+
+extern uint8_t wsInFlightCount;
+extern uint8_t wsOutboxCount;
+extern unsigned long wsLastRoundTrip;
+extern unsigned long wsSentCount;
+extern unsigned long wsDroppedCount;
+
+const uint32_t ROUND_TRIP_MS = 20;
+
+// One loop() worth of WebSocket work per simulated millisecond
+void runFor(uint32_t ms) {
+  for (uint32_t i = 0; i < ms; i++) {
+    simAdvanceUs(1000);
+    webSocketLoop();
+  }
+}
+
+// Connects and waits for Wi-Fi and the handshake
+void connect() {
+  webSocketConnect();
+  runFor(simWifiJoinUs / 1000 + ROUND_TRIP_MS + 2);
+}
+
+void setUp() {
+  webSocketDisconnect();
+  simWifiAccessPoint = true;
+  simWsServerUp = true;
+  simWsServerAnswers = true;
+  simWsLatencyUs = ROUND_TRIP_MS * 1000;
+  simWsRequests.clear();
+  for (uint8_t i = 0; i < 4; i++) restoreSwitchState(i, false);
+  wsSentCount = 0;
+  wsDroppedCount = 0;
+  wsLastRoundTrip = 0;
+}
+
+void tearDown() {}
+
+// Drawing the status screen must not start the radio; entering the menu does
+void test_status_screen_does_not_connect() {
+  webSocketStatusUI();
+  runFor(1000);
+  TEST_ASSERT_EQUAL(WIFI_OFF, WiFi.getMode());
+  TEST_ASSERT_EQUAL(0, simWsRequests.size());
+}
+
+void test_connects_once_wifi_is_up() {
+  webSocketConnect();
+  webSocketSendSwitch(0, true);
+  runFor(simWifiJoinUs / 1000 - 1);
+  TEST_ASSERT_EQUAL(0, simWsRequests.size());  // Queued until Wi-Fi and the handshake are done
+  runFor(ROUND_TRIP_MS + 2);
+  TEST_ASSERT_EQUAL(1, simWsRequests.size());
+}
+
+// A burst of commands goes out at once and is answered after a single round trip
+void test_requests_are_pipelined() {
+  connect();
+  for (uint8_t i = 0; i < 8; i++) webSocketSendSwitch(i % 4, i < 4);
+  TEST_ASSERT_EQUAL(8, simWsRequests.size());
+  TEST_ASSERT_EQUAL(8, wsInFlightCount);
+
+  uint64_t start = simNowUs();
+  while (wsInFlightCount > 0 && simNowUs() - start < 1000000) runFor(1);
+  uint32_t burstMs = (simNowUs() - start) / 1000;
+  TEST_ASSERT_EQUAL(0, wsInFlightCount);
+  TEST_ASSERT_LESS_OR_EQUAL(ROUND_TRIP_MS + 1, burstMs);
+  TEST_ASSERT_EQUAL(ROUND_TRIP_MS, wsLastRoundTrip);
+  TEST_ASSERT_EQUAL(0, wsDroppedCount);
+
+  char message[80];
+  snprintf(message, sizeof(message), "8 commands answered in %lu ms (round trip %lu ms)", (unsigned long)burstMs, (unsigned long)ROUND_TRIP_MS);
+  TEST_MESSAGE(message);
+}
+
+void test_offline_requests_keep_their_order() {
+  webSocketConnect();
+  for (uint8_t i = 0; i < 4; i++) webSocketSendSwitch(i, true);
+  webSocketSendAcState(WS_AC_DAIKIN);
+  runFor(simWifiJoinUs / 1000 + ROUND_TRIP_MS + 2);
+
+  TEST_ASSERT_EQUAL(5, simWsRequests.size());
+  for (uint8_t i = 0; i < 5; i++) TEST_ASSERT_EQUAL_UINT8(simWsRequests[0][1] + i, simWsRequests[i][1]);  // Sequence numbers
+  for (uint8_t i = 0; i < 4; i++) TEST_ASSERT_EQUAL(WS_OP_SWITCH_SET, simWsRequests[i][0]);
+  TEST_ASSERT_EQUAL(WS_OP_AC_STATE, simWsRequests[4][0]);
+}
+
+// More requests than the pipeline holds wait in the outbox and follow as responses come back
+void test_full_pipeline_queues_the_rest() {
+  connect();
+  for (uint8_t i = 0; i < 20; i++) webSocketSendIr(WS_IR_NEC, i, 32);
+  TEST_ASSERT_EQUAL(16, simWsRequests.size());
+  TEST_ASSERT_EQUAL(4, wsOutboxCount);
+
+  runFor(ROUND_TRIP_MS + 1);
+  TEST_ASSERT_EQUAL(20, simWsRequests.size());
+  runFor(ROUND_TRIP_MS + 1);
+  TEST_ASSERT_EQUAL(0, wsInFlightCount);
+  TEST_ASSERT_EQUAL(20, wsSentCount);
+}
+
+void test_unanswered_requests_expire() {
+  connect();
+  simWsServerAnswers = false;
+  webSocketSendSwitch(1, true);
+  runFor(5000);
+  TEST_ASSERT_EQUAL(1, wsInFlightCount);
+  runFor(2);
+  TEST_ASSERT_EQUAL(0, wsInFlightCount);
+  TEST_ASSERT_EQUAL(1, wsDroppedCount);
+}
+
+void test_switch_state_from_server() {
+  connect();
+  webSocketToggleSwitch(2);
+  runFor(ROUND_TRIP_MS + 1);
+  TEST_ASSERT_TRUE(getSwitchState(2));  // Response carries the state
+  TEST_ASSERT_EQUAL(1, simWsSwitchState[2]);
+
+  simWsPush({WS_OP_STATE_PUSH, 0, 3, 1, 1});
+  runFor(1);
+  TEST_ASSERT_TRUE(getSwitchState(3));  // Pushed without a request
+}
+
+void test_lost_connection_drops_requests_in_flight() {
+  connect();
+  webSocketSendSwitch(0, true);
+  simWsServerUp = false;
+  runFor(1);
+  TEST_ASSERT_EQUAL(0, wsInFlightCount);
+  TEST_ASSERT_EQUAL(1, wsDroppedCount);
+
+  simWsServerUp = true;  // The client reconnects by itself
+  webSocketSendSwitch(0, true);
+  runFor(ROUND_TRIP_MS + 2);
+  TEST_ASSERT_EQUAL(2, simWsRequests.size());
+}
+
+int main() {
+  simQuiet = true;
+  UNITY_BEGIN();
+  RUN_TEST(test_status_screen_does_not_connect);
+  RUN_TEST(test_connects_once_wifi_is_up);
+  RUN_TEST(test_requests_are_pipelined);
+  RUN_TEST(test_offline_requests_keep_their_order);
+  RUN_TEST(test_full_pipeline_queues_the_rest);
+  RUN_TEST(test_unanswered_requests_expire);
+  RUN_TEST(test_switch_state_from_server);
+  RUN_TEST(test_lost_connection_drops_requests_in_flight);
+  return UNITY_END();
+}
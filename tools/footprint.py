@@ -0,0 +1,162 @@
+"""PlatformIO extra script: per-module flash/RAM footprint report with budgets.
+
+After linking, the linker map file is split by module (a source file of src/, or a library /
+framework archive) and the bytes each one adds to the image (flash: code, constants and
+initialized data) and to static DRAM (initialized data and bss) are printed, largest first.
+The build fails when a module or the total goes over its budget in platformio.ini:
+
+    custom_footprint_budgets =
+        total = auto
+        IRremoteESP8266 = 32768 / 2048
+
+(flash / RAM in bytes, "-" for no limit; modules are named as in the report). "auto" budgets are
+the sizes of the first build plus BUDGET_HEADROOM, recorded in tools/footprint_<env>.txt (same
+line format). Commit that file; delete it to take the sizes of the next build as the new budgets.
+
+Enabled with `extra_scripts = pre:tools/footprint.py`.
+"""
+
+import os
+import re
+from collections import defaultdict
+
+Import("env")  # noqa: F821 (provided by PlatformIO)
+
+REPORT_LINES = 25  # Largest modules printed, the rest is summed up
+BUDGET_HEADROOM = 10  # Percent above the measured size in the recorded budgets
+MAP_FILE = os.path.join(env.subst("$BUILD_DIR"), "firmware.map")
+RECORDED_FILE = os.path.join(env.subst("$PROJECT_DIR"), "tools", "footprint_%s.txt" % env.subst("$PIOENV"))
+ARCHIVE_PATTERN = re.compile(r"lib([^/\\]+)\.a\(")
+
+
+def section_regions(section):
+    """(in flash image, in static DRAM) for an output section of the ESP32 linker script."""
+    if not section.startswith((".flash", ".iram0", ".dram0", ".rtc", ".noinit")):
+        return False, False  # Debug information and other sections that are not loaded
+    loaded = not section.endswith(("bss", "noinit", "noload"))
+    return loaded, section.startswith(".dram0") or section == ".noinit"
+
+
+def module_name(obj):
+    archive = ARCHIVE_PATTERN.search(obj)
+    if archive:
+        return archive.group(1)
+    obj = obj.replace("\\", "/")
+    if "/src/" in obj:
+        return "src/" + obj.split("/src/", 1)[1].replace(".o", "")
+    return os.path.basename(obj)
+
+
+def parse_map(path):
+    usage = defaultdict(lambda: [0, 0])  # module -> [flash, ram]
+    in_memory_map = False
+    regions = (False, False)
+    pending = False  # Input section name on its own line, address and size on the next one
+
+    with open(path, encoding="utf-8", errors="replace") as map_file:
+        for line in map_file:
+            if not in_memory_map:
+                in_memory_map = line.startswith("Linker script and memory map")
+                continue
+            if line[:1] not in (" ", "\t", "\n", ""):  # Output section
+                regions = section_regions(line.split()[0])
+                continue
+
+            parts = line.split()
+            if line.startswith((" .", " COMMON")):
+                if len(parts) == 1:
+                    pending = True
+                    continue
+                parts = parts[1:]
+            elif not pending:
+                continue
+            pending = False
+
+            if len(parts) < 3 or not parts[0].startswith("0x") or not parts[1].startswith("0x"):
+                continue
+            size = int(parts[1], 16)
+            module = usage[module_name(" ".join(parts[2:]))]
+            if regions[0]:
+                module[0] += size
+            if regions[1]:
+                module[1] += size
+    return usage
+
+
+def parse_budgets(text):
+    """name -> (flash, RAM), None for no limit, or "auto" for a recorded budget."""
+    budgets = {}
+    for line in text.splitlines():
+        if "=" not in line or line.lstrip().startswith(("#", ";")):
+            continue
+        name, limits = (part.strip() for part in line.split("=", 1))
+        if limits == "auto":
+            budgets[name] = limits
+            continue
+        flash, ram = (value.strip() for value in (limits.split("/") + ["-"])[:2])
+        budgets[name] = (None if flash == "-" else int(flash, 0), None if ram == "-" else int(ram, 0))
+    return budgets
+
+
+def recorded_budgets(budgets, usage, total):
+    """Fills in the "auto" budgets from RECORDED_FILE, or records them from this build."""
+    auto = sorted(name for name, limits in budgets.items() if limits == "auto")
+    if not auto:
+        return budgets
+
+    recorded = {}
+    if os.path.isfile(RECORDED_FILE):
+        with open(RECORDED_FILE, encoding="utf-8") as recorded_file:
+            recorded = parse_budgets(recorded_file.read())
+    if any(name not in recorded for name in auto):
+        with open(RECORDED_FILE, "w", encoding="utf-8") as recorded_file:
+            recorded_file.write("# Footprint budgets of %s: first build + %d%% (tools/footprint.py)\n" % (env.subst("$PIOENV"), BUDGET_HEADROOM))
+            for name in auto:
+                used = total if name == "total" else usage.get(name, [0, 0])
+                recorded[name] = (suggested_budget(used[0]), suggested_budget(used[1]))
+                recorded_file.write("%s = %d / %d\n" % (name, recorded[name][0], recorded[name][1]))
+        print("Footprint budgets recorded in %s, commit it" % os.path.relpath(RECORDED_FILE, env.subst("$PROJECT_DIR")))
+
+    return {name: recorded[name] if limits == "auto" else limits for name, limits in budgets.items()}
+
+
+def suggested_budget(size):
+    """Measured size plus BUDGET_HEADROOM, rounded up to a whole KiB (at least one)."""
+    return max(1, -(-size * (100 + BUDGET_HEADROOM) // 100 // 1024)) * 1024
+
+
+def footprint_report(source, target, env):
+    if not os.path.isfile(MAP_FILE):
+        print("Footprint: %s not found" % MAP_FILE)
+        return 0
+
+    usage = parse_map(MAP_FILE)
+    total = [sum(flash for flash, _ in usage.values()), sum(ram for _, ram in usage.values())]
+    ranked = sorted(usage.items(), key=lambda item: item[1][0], reverse=True)
+
+    print("Footprint (bytes)          flash      RAM")
+    for name, (flash, ram) in ranked[:REPORT_LINES]:
+        print("  %-22s %9d %8d" % (name[:22], flash, ram))
+    others = ranked[REPORT_LINES:]
+    if others:
+        print("  %-22s %9d %8d" % ("(%d others)" % len(others), sum(u[0] for _, u in others), sum(u[1] for _, u in others)))
+    print("  %-22s %9d %8d" % ("total", total[0], total[1]))
+
+    budgets = recorded_budgets(parse_budgets(env.GetProjectOption("custom_footprint_budgets", "")), usage, total)
+    over = []
+    for name, limits in budgets.items():
+        used = total if name == "total" else usage.get(name, [0, 0])
+        for region, limit, value in (("flash", limits[0], used[0]), ("RAM", limits[1], used[1])):
+            if limit is not None and value > limit:
+                over.append("%s %s: %d bytes, budget %d" % (name, region, value, limit))
+
+    if over:
+        for line in over:
+            print("Footprint budget exceeded: " + line)
+        os.remove(target[0].get_abspath())  # Link again next time, so the check is not skipped
+        return 1
+    return 0
+
+
+env.Append(LINKFLAGS=["-Wl,-Map," + MAP_FILE])
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", footprint_report)
@@ -0,0 +1,72 @@
+"""PlatformIO extra script: compile only the IRremoteESP8266 protocols the firmware uses.
+
+The sources are scanned for the library's A/C classes (IRSharpAc, IRDaikin64, ...) and
+IRsend/IRrecv calls (sendNEC(), decodeRC6(), ...). The library is then built with
+_IR_ENABLE_DEFAULT_=false plus SEND_<PROTOCOL>=true for each protocol found, so every other
+encoder and decoder is left out. NEC, RC6 and Symphony frames are generated by
+src/ir_emitter.cpp itself and need nothing from the library.
+
+Protocols used in a way the scan cannot see can be added in platformio.ini:
+    custom_ir_protocols = SHARP_AC DAIKIN64
+
+Enabled with `extra_scripts = pre:tools/ir_protocols.py`.
+"""
+
+import os
+import re
+
+Import("env")  # noqa: F821 (provided by PlatformIO)
+
+SOURCE_EXTENSIONS = (".c", ".cpp", ".h", ".hpp", ".ino")
+CLASS_PATTERN = re.compile(r"\bIR([A-Z][A-Za-z0-9]*)\b")                      # IRSharpAc -> SharpAc
+CALL_PATTERN = re.compile(r"\b(?:IRsend::|IRrecv::|irsend\.|irrecv\.)(send|decode)([A-Z][A-Za-z0-9]*)\s*\(")
+CLASS_ALIASES = {"DAIKIN_ESP": "DAIKIN"}  # Library classes whose name is not the protocol name
+
+
+def protocol_name(camel):
+    """SharpAc -> SHARP_AC, Daikin64 -> DAIKIN64, NEC -> NEC."""
+    return re.sub(r"(?<=[a-z0-9])(?=[A-Z])", "_", camel).upper()
+
+
+def scan_sources(directory):
+    sends, decodes = set(), set()
+    for root, _, files in os.walk(directory):
+        for name in files:
+            if not name.endswith(SOURCE_EXTENSIONS):
+                continue
+            with open(os.path.join(root, name), encoding="utf-8", errors="replace") as source:
+                text = source.read()
+            for match in CLASS_PATTERN.finditer(text):
+                protocol = protocol_name(match.group(1))
+                sends.add(CLASS_ALIASES.get(protocol, protocol))
+            for kind, camel in CALL_PATTERN.findall(text):
+                (sends if kind == "send" else decodes).add(protocol_name(camel))
+    return sends, decodes
+
+
+def library_protocols():
+    """SEND_* names defined by the installed library, None if it is not installed yet."""
+    header = os.path.join(env.subst("$PROJECT_LIBDEPS_DIR"), env.subst("$PIOENV"), "IRremoteESP8266", "src", "IRremoteESP8266.h")
+    if not os.path.isfile(header):
+        return None
+    with open(header, encoding="utf-8", errors="replace") as source:
+        return set(re.findall(r"#define\s+SEND_([A-Z0-9_]+)\b", source.read()))
+
+
+sends, decodes = scan_sources(env.subst("$PROJECT_SRC_DIR"))
+sends |= set(env.GetProjectOption("custom_ir_protocols", "").split())
+
+known = library_protocols()
+if known is not None:
+    for protocol in sorted((sends | decodes) - known):
+        print("IR protocols: ignoring %s, not a protocol of IRremoteESP8266" % protocol)
+    sends &= known
+    decodes &= known
+
+if not sends and not decodes:
+    print("IR protocols: none found, building the whole library")
+else:
+    env.Append(CPPDEFINES=[("_IR_ENABLE_DEFAULT_", "false")]
+               + [("SEND_" + protocol, "true") for protocol in sorted(sends)]
+               + [("DECODE_" + protocol, "true") for protocol in sorted(decodes)])
+    print("IR protocols: send %s, decode %s" % (" ".join(sorted(sends)) or "-", " ".join(sorted(decodes)) or "-"))
@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Create a delta patch for the peer-to-peer firmware update (see lib/delta_ota/delta_ota.h).
+
+Usage:
+    python tools/make_delta.py --key KEY old_firmware.bin new_firmware.bin patch.bin
+    python tools/make_delta.py --new-key
+
+The patch is signed with KEY (64 hex digits, HMAC-SHA256). Devices only accept patches signed
+with their deltaOtaKey (lib/delta_ota/delta_ota.cpp); --new-key prints a random key in both forms.
+
+Seed the first peer by flashing the new firmware and writing the patch into its
+"patch" partition (offset from partitions.csv):
+    pio run -t upload
+    esptool.py write_flash 0x298000 patch.bin
+"""
+
+import argparse
+import hashlib
+import hmac
+import os
+import struct
+
+MAGIC = 0x50445248  # "HRDP"
+OP_COPY = 0x01
+OP_INSERT = 0x02
+BLOCK = 16     # Minimum match length worth a COPY (9 bytes of op overhead)
+HEADER_SIZE = 112  # Including the 32-byte signature
+
+
+def index_blocks(old):
+    """Map every BLOCK-byte window of the old image to its first offset."""
+    index = {}
+    for offset in range(len(old) - BLOCK + 1):
+        index.setdefault(old[offset:offset + BLOCK], offset)
+    return index
+
+
+def diff(old, new):
+    index = index_blocks(old)
+    ops = []
+    literal = bytearray()
+    i = 0
+    expected = None  # Old offset that continues the previous COPY (cheap check before the index lookup)
+
+    while i < len(new):
+        offset = None
+        window = new[i:i + BLOCK]
+        if len(window) == BLOCK:
+            if expected is not None and old[expected:expected + BLOCK] == window:
+                offset = expected
+            else:
+                offset = index.get(window)
+
+        if offset is None:
+            literal.append(new[i])
+            i += 1
+            expected = None
+            continue
+
+        # Extend the match forward as far as it goes
+        length = BLOCK
+        while i + length < len(new) and offset + length < len(old) and new[i + length] == old[offset + length]:
+            length += 1
+
+        if literal:
+            ops.append((OP_INSERT, bytes(literal)))
+            literal = bytearray()
+        ops.append((OP_COPY, offset, length))
+        i += length
+        expected = offset + length
+
+    if literal:
+        ops.append((OP_INSERT, bytes(literal)))
+    return ops
+
+
+def encode(ops):
+    out = bytearray()
+    for op in ops:
+        if op[0] == OP_COPY:
+            out += struct.pack("<BII", OP_COPY, op[1], op[2])
+        else:
+            out += struct.pack("<BI", OP_INSERT, len(op[1])) + op[1]
+    return bytes(out)
+
+
+def make_patch(old, new, key):
+    body = encode(diff(old, new))
+    header = struct.pack("<IIII32s32s", MAGIC, HEADER_SIZE + len(body), len(old), len(new),
+                         hashlib.sha256(old).digest(), hashlib.sha256(new).digest())
+    return header + hmac.new(key, header, hashlib.sha256).digest() + body
+
+
+def parse_key(text):
+    key = bytes.fromhex(text)
+    if len(key) != 32 or not any(key):
+        raise argparse.ArgumentTypeError("the key must be 64 hex digits and not all zeros")
+    return key
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--key", type=parse_key, help="signing key, 64 hex digits")
+    parser.add_argument("--new-key", action="store_true", help="print a random key and exit")
+    parser.add_argument("files", nargs="*", metavar="old new patch")
+    args = parser.parse_args()
+
+    if args.new_key:
+        key = os.urandom(32)
+        print(f"--key {key.hex()}")
+        print("uint8_t deltaOtaKey[32] = {" + ", ".join(f"0x{b:02X}" for b in key) + "};")
+        return
+    if args.key is None or len(args.files) != 3:
+        parser.error("--key and the old, new and patch files are required")
+
+    with open(args.files[0], "rb") as f:
+        old = f.read()
+    with open(args.files[1], "rb") as f:
+        new = f.read()
+
+    patch = make_patch(old, new, args.key)
+    with open(args.files[2], "wb") as f:
+        f.write(patch)
+
+    print(f"old {len(old)} bytes, new {len(new)} bytes, patch {len(patch)} bytes "
+          f"({100 * len(patch) / len(new):.1f}% of a full image)")
+
+
+if __name__ == "__main__":
+    main()